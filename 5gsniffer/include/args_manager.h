@@ -1,5 +1,3 @@
-
-
 #ifndef ARGS_MANAGER_H
 #define ARGS_MANAGER_H
 
@@ -9,12 +7,16 @@
 struct args_t {
   int force_N_id_2;
   std::string input_file_name = "";
+  std::string zmq_address = "";
   std::string rf_args;
   std::string rf_dev;
   double rf_freq;
   double rf_gain;
-
-
+  uint64_t sample_rate;
+  uint16_t ssb_numerology;
+  float threshold;
+  uint32_t num_threads;
+  std::string fft_wisdom_path;
   };
 
 class args_manager {
@@ -26,4 +28,4 @@ private:
   args_manager() = delete;
 };
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,56 @@
+#ifndef CELL_DETECTOR_H
+#define CELL_DETECTOR_H
+
+#include <complex>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <vector>
+#include "dsp.h"
+#include "phy_params_common.h"
+
+namespace nr {
+  /**
+   * Finds the SSBs of every cell in a block of samples at the SSB sample rate
+   * (ssb_nfft samples per symbol). The PSS of all NID2 are correlated in the
+   * frequency domain at once, and each PSS peak is confirmed by correlating
+   * the SSS that follows it against all NID1. Cells sharing a NID2 and SSB
+   * timing have a single PSS peak, but are told apart by their SSS.
+   */
+  class cell_detector {
+    public:
+      struct detection {
+        uint16_t nid1;
+        uint8_t nid2;
+        size_t pss_position; ///< Start of the useful part of the PSS
+        float pss_correlation; ///< Normalized
+        float sss_correlation; ///< Normalized
+        uint16_t get_cell_id() const { return 3 * nid1 + nid2; }
+      };
+
+      /**
+       * @param threshold minimum normalized PSS and SSS correlation of a cell
+       * @param max_cells maximum number of cells reported, the strongest first
+       * @param cp_length CP length of the SSS and of the symbol before it
+       */
+      cell_detector(float threshold, size_t max_cells, size_t cp_length);
+
+      /**
+       * Replaces detections by the cells whose PSS and SSS both lie in samples,
+       * by decreasing SSS correlation.
+       */
+      void detect(std::vector<detection>& detections, std::span<const std::complex<float>> samples);
+
+    private:
+      void correlate_sss(std::vector<float>& correlations, std::span<const std::complex<float>> symbol, uint8_t nid2);
+
+      float threshold;
+      size_t max_cells;
+      size_t sss_offset; ///< From the start of the PSS to the start of the SSS
+      std::unique_ptr<overlap_save_correlator> pss_correlator;
+      std::vector<float> pss_norms;
+      std::vector<std::complex<float>> sss_res;
+  };
+}
+
+#endif // CELL_DETECTOR_H
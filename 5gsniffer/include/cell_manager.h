@@ -0,0 +1,55 @@
+#ifndef CELL_MANAGER_H
+#define CELL_MANAGER_H
+
+#include <cstdint>
+#include <complex>
+#include <memory>
+#include <string>
+#include <vector>
+#include "worker.h"
+#include "syncer.h"
+#include "phy.h"
+#include "flow_pool.h"
+#include "decimator.h"
+#include "cell_detector.h"
+
+namespace nr {
+  /**
+   * Follows every cell of a capture. The capture is periodically searched for
+   * cells, and each new cell gets a syncer of its own, locked to its PCI. The
+   * syncers all receive the same samples, and acquire their flows from one
+   * shared pool.
+   */
+  class cell_manager : public worker {
+    public:
+      cell_manager(uint64_t sample_rate, uint16_t ssb_numerology, const std::string& zmq_address);
+      virtual ~cell_manager();
+      void process(shared_ptr<vector<complex<float>>>& samples, int64_t metadata) override;
+    private:
+      struct cell {
+        uint16_t cell_id;
+        shared_ptr<nr::phy> phy;
+        shared_ptr<syncer> cell_syncer;
+        uint64_t unsynchronized_samples; ///< Since the cell was last synchronized
+      };
+
+      void search(const vector<complex<float>>& samples);
+      void add_cell(const cell_detector::detection& detection, size_t num_samples);
+      void retire_cells(size_t num_samples);
+
+      uint64_t sample_rate;
+      uint16_t ssb_numerology;
+      shared_ptr<bandwidth_part> ssb_bwp;
+      shared_ptr<flow_pool> pool;
+      decimator downsampler;
+      cell_detector detector;
+      vector<cell> cells;
+      bool searching;
+      vector<complex<float>> search_samples; ///< Downsampled samples of the search in progress
+      uint64_t search_start; ///< Sample at which the search in progress started
+      uint64_t next_search; ///< Sample at which the next search starts
+      uint64_t total_samples; ///< Samples received before the current chunk
+  };
+}
+
+#endif // CELL_MANAGER_H
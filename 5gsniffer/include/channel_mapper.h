@@ -24,6 +24,13 @@ class channel_mapper : public worker {
     channel_mapper(shared_ptr<nr::phy> phy, pdcch_config pdcch_config);
     virtual ~channel_mapper();
     void process(shared_ptr<vector<symbol>>& symbols, int64_t metadata) override;
+    void process(const shared_ptr<slot_grid>& grid, int64_t metadata) override;
+
+    /**
+     * Indices in the slot of the symbols the CORESET occupies, the only ones
+     * the mapper reads.
+     */
+    vector<uint8_t> get_symbol_indices();
 
     shared_ptr<nr::phy> phy;
     
@@ -38,6 +38,21 @@ typedef struct pdcch_config {
   uint8_t coreset_interleaver_size;
   int64_t sample_rate_time;
   int rnti_list_length;
+  bool rnti_recovery;
+  uint8_t rnti_recovery_min_hits;
+  uint32_t rnti_recovery_window_ms;
+  bool scrambling_id_solver;
+  uint32_t dmrs_cache_size_mb;
+  bool dmrs_prefetch;
+  bool hierarchical_search;
+  float hierarchical_energy_ratio;
+  uint32_t threads;
+  uint32_t rnti_aging_ms;
+  uint32_t slot_budget_us;
+  uint32_t max_lag_ms;
+  uint32_t discovery_ms;
+  uint32_t rescan_period_ms;
+  uint32_t rescan_ms;
 } pdcch_config;
 
 // MHZ - RNTI tracker configuration  
@@ -58,6 +73,15 @@ struct config {
   string rf_args;
   uint16_t ssb_numerology;
   string zmq_address;
+  bool tracking;
+  float tracking_min_correlation;
+  uint32_t tracking_max_misses;
+  bool multi_cell;
+  uint32_t max_cells;
+  float cell_search_threshold;
+  uint32_t cell_search_period_ms;
+  uint32_t cell_timeout_ms;
+  string fft_wisdom_path;
 
   vector<pdcch_config> pdcch_configs;
 
@@ -82,6 +106,18 @@ struct config {
     string zmq_port = toml["sniffer"]["zmq_port"].value_or("23501"sv).data();
     conf.zmq_address = "tcp://" + zmq_ip + ":" + zmq_port;
 
+    conf.tracking = toml["sniffer"]["tracking"].value_or(false);
+    conf.tracking_min_correlation = toml["sniffer"]["tracking_min_correlation"].value_or(0.2f);
+    conf.tracking_max_misses = toml["sniffer"]["tracking_max_misses"].value_or(3);
+
+    conf.multi_cell = toml["sniffer"]["multi_cell"].value_or(false);
+    conf.max_cells = toml["sniffer"]["max_cells"].value_or(8);
+    conf.cell_search_threshold = toml["sniffer"]["cell_search_threshold"].value_or(0.3f);
+    conf.cell_search_period_ms = toml["sniffer"]["cell_search_period_ms"].value_or(1000);
+    conf.cell_timeout_ms = toml["sniffer"]["cell_timeout_ms"].value_or(1000);
+
+    conf.fft_wisdom_path = toml["sniffer"]["fft_wisdom_path"].value_or("fftw_wisdom"sv).data();
+
     // MHZ - RNTI tracker config
     if (toml.contains("rnti_tracker") && toml["rnti_tracker"].is_table()) {
       toml::table tracker_table = *toml["rnti_tracker"].as_table();
@@ -137,6 +173,21 @@ struct config {
         pdcch_cfg.max_rnti_queue_size = pdcch_table["max_rnti_queue_size"].value_or(0xffff);
         pdcch_cfg.sample_rate_time = conf.sample_rate;
         pdcch_cfg.rnti_list_length = pdcch_table["rnti_list_length"].value_or(0xffff);
+        pdcch_cfg.rnti_recovery = pdcch_table["rnti_recovery"].value_or(false);
+        pdcch_cfg.rnti_recovery_min_hits = pdcch_table["rnti_recovery_min_hits"].value_or(2);
+        pdcch_cfg.rnti_recovery_window_ms = pdcch_table["rnti_recovery_window_ms"].value_or(1000);
+        pdcch_cfg.scrambling_id_solver = pdcch_table["scrambling_id_solver"].value_or(false);
+        pdcch_cfg.dmrs_cache_size_mb = pdcch_table["dmrs_cache_size_mb"].value_or(64);
+        pdcch_cfg.dmrs_prefetch = pdcch_table["dmrs_prefetch"].value_or(true);
+        pdcch_cfg.hierarchical_search = pdcch_table["hierarchical_search"].value_or(false);
+        pdcch_cfg.hierarchical_energy_ratio = pdcch_table["hierarchical_energy_ratio"].value_or(0.5);
+        pdcch_cfg.threads = pdcch_table["threads"].value_or(0);
+        pdcch_cfg.rnti_aging_ms = pdcch_table["rnti_aging_ms"].value_or(0);
+        pdcch_cfg.slot_budget_us = pdcch_table["slot_budget_us"].value_or(0);
+        pdcch_cfg.max_lag_ms = pdcch_table["max_lag_ms"].value_or(0);
+        pdcch_cfg.discovery_ms = pdcch_table["discovery_ms"].value_or(0);
+        pdcch_cfg.rescan_period_ms = pdcch_table["rescan_period_ms"].value_or(10000);
+        pdcch_cfg.rescan_ms = pdcch_table["rescan_ms"].value_or(500);
         toml::array* dci_array = pdcch_table["dci_sizes_list"].as<toml::array>();
         // Parse the DCI array list and if is not included, add 39 by default (e.g. System Information)
         if(dci_array){
@@ -36,8 +36,8 @@ class dci
     void set_correlation(float);
 
     bool get_found_possible_dci();
-    uint8_t get_found_aggregation_level();
-    uint8_t get_found_candidate();
+    uint8_t get_found_aggregation_level() const;
+    uint8_t get_found_candidate() const;
     uint8_t get_max_num_candidate();
     uint8_t get_coreset_id();
     uint8_t get_coreset_start_rb();
@@ -46,8 +46,8 @@ class dci
     uint16_t get_rnti();
     std::vector<uint8_t> get_payload();
     uint16_t get_nof_bits();
-    uint16_t get_pdcch_scrambling_id();
-    uint8_t get_n_slot();
+    uint16_t get_pdcch_scrambling_id() const;
+    uint8_t get_n_slot() const;
     uint8_t get_n_ofdm();
     uint8_t get_num_symbols_per_slot(uint8_t);
     float get_correlation();
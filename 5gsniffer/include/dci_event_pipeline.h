@@ -0,0 +1,145 @@
+#ifndef DCI_EVENT_PIPELINE_H
+#define DCI_EVENT_PIPELINE_H
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace nr {
+  /**
+   * Decoded DCI as handed from the decode path to the event consumer. It is
+   * trivially copyable and has a fixed size, so it fits in a ring slot.
+   */
+  struct dci_record {
+    static constexpr size_t max_payload_bits = 256;
+
+    uint16_t rnti;
+    uint16_t cell_id;
+    uint16_t scrambling_id;
+    uint8_t coreset_id;
+    uint8_t aggregation_level;
+    uint8_t candidate_idx;
+    uint8_t slot;
+    uint8_t ofdm_symbol;
+    uint8_t nof_bits;
+    int32_t symbol_in_chunk;
+    float correlation;
+    int64_t sample_index;
+    uint64_t sample_rate;
+    std::array<uint8_t, max_payload_bits / 8> payload; ///< DCI bits packed MSB first
+
+    void pack_payload(const uint8_t* bits, uint8_t nof_bits_);
+    void unpack_payload(uint8_t* bits) const;
+  };
+  static_assert(std::is_trivially_copyable_v<dci_record>);
+
+  /**
+   * Lock-free ring with a single producer and a single consumer. A push into
+   * a full ring drops the record and counts it, the producer never waits.
+   */
+  template <typename T, size_t capacity>
+  class spsc_ring {
+    static_assert((capacity & (capacity - 1)) == 0, "capacity must be a power of two");
+
+    public:
+      bool push(const T& item) {
+        size_t tail_ = tail.load(std::memory_order_relaxed);
+        if (tail_ - head.load(std::memory_order_acquire) == capacity) {
+          dropped.fetch_add(1, std::memory_order_relaxed);
+          return false;
+        }
+        slots[tail_ & (capacity - 1)] = item;
+        tail.store(tail_ + 1, std::memory_order_release);
+        return true;
+      }
+
+      bool pop(T& item) {
+        size_t head_ = head.load(std::memory_order_relaxed);
+        if (head_ == tail.load(std::memory_order_acquire)) {
+          return false;
+        }
+        item = slots[head_ & (capacity - 1)];
+        head.store(head_ + 1, std::memory_order_release);
+        return true;
+      }
+
+      bool empty() const {
+        return head.load(std::memory_order_acquire) == tail.load(std::memory_order_acquire);
+      }
+
+      /* Records dropped because the ring was full */
+      uint64_t get_dropped() const { return dropped.load(std::memory_order_relaxed); }
+
+    private:
+      alignas(64) std::atomic<size_t> head = 0;
+      alignas(64) std::atomic<size_t> tail = 0;
+      alignas(64) std::atomic<uint64_t> dropped = 0;
+      std::array<T, capacity> slots;
+  };
+
+  /**
+   * Process-wide pipeline that takes the reporting of decoded DCIs off the
+   * decode threads. Each producing thread pushes into its own SPSC ring, and a
+   * consumer thread drains all rings and runs the handler, which by default
+   * prints and logs the DCI and feeds the RNTI tracker. Until start() is
+   * called, and after stop(), records are handled on the publishing thread.
+   */
+  class dci_event_pipeline {
+    public:
+      static constexpr size_t ring_capacity = 1024;
+      using ring = spsc_ring<dci_record, ring_capacity>;
+      using handler = std::function<void(const dci_record&)>;
+
+      static dci_event_pipeline& instance();
+
+      void start();
+
+      /**
+       * Stops the consumer thread once it has handled every queued record,
+       * including those of publishers that were pushing while it stopped.
+       */
+      void stop();
+
+      /**
+       * Queues a record on the ring of the calling thread.
+       *
+       * @return false if the ring was full and the record was dropped
+       */
+      bool publish(const dci_record& record);
+
+      /* Replaces the handler, only while the pipeline is stopped */
+      void set_handler(handler handler_);
+      handler get_handler() const { return handle; }
+
+      /* Records dropped by all rings since the pipeline was created */
+      uint64_t get_dropped();
+
+      /* Prints and logs a DCI, and feeds it to the RNTI tracker if enabled */
+      static void report(const dci_record& record);
+
+    private:
+      dci_event_pipeline();
+      ~dci_event_pipeline();
+
+      ring* thread_ring();
+      bool drain();
+      void consumer_loop();
+
+      std::mutex rings_mutex;
+      std::vector<std::unique_ptr<ring>> rings;
+      handler handle;
+      std::atomic<bool> running = false;
+      std::atomic<uint32_t> publishers = 0; ///< Threads between their running check and their push
+      std::thread consumer;
+      uint64_t reported_dropped = 0; ///< Drops already logged by the consumer
+  };
+}
+
+#endif // DCI_EVENT_PIPELINE_H
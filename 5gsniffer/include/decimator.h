@@ -0,0 +1,61 @@
+#ifndef DECIMATOR_H
+#define DECIMATOR_H
+
+#include <cstdint>
+#include <vector>
+#include <complex>
+#include <span>
+#include <liquid/liquid.h>
+
+using namespace std;
+
+/**
+ * Lowpass filters and downsamples a stream of samples. When the input rate is
+ * an integer multiple of the output rate, a decimating FIR computes only the
+ * kept outputs (the polyphase form of the filter) with volk dot products over
+ * whole blocks. Other ratios fall back to liquid's arbitrary-rate resampler.
+ * The filter state is kept between calls, so consecutive blocks are filtered
+ * as one continuous stream.
+ */
+class decimator {
+  public:
+    /**
+     * @param input_rate sample rate of the input
+     * @param output_rate sample rate of the output, at most input_rate
+     * @param h_len filter semi-length, in input samples
+     * @param bw filter cutoff relative to the input rate
+     * @param slsl filter sidelobe suppression level in dB
+     * @param npfb number of filters in the bank of the arbitrary-rate resampler
+     */
+    decimator(uint64_t input_rate, uint64_t output_rate, unsigned int h_len, float bw, float slsl, unsigned int npfb);
+    ~decimator();
+    decimator(const decimator&) = delete;
+    decimator& operator=(const decimator&) = delete;
+
+    /**
+     * Filters input and appends the downsampled samples to output.
+     */
+    void execute(span<const complex<float>> input, vector<complex<float>>& output);
+
+    /**
+     * Clears the filter state.
+     */
+    void reset();
+
+    bool is_integer() const { return factor > 0; }
+    /* Group delay of the filter, in input samples */
+    unsigned int get_delay() const { return delay; }
+    uint32_t get_factor() const { return factor; }
+    float get_rate() const { return rate; }
+
+  private:
+    float rate;
+    uint32_t factor; ///< Integer decimation factor, 0 for the arbitrary-rate resampler
+    unsigned int delay;
+    vector<float> taps; ///< Filter taps in reverse order, so each output is a dot product with the input
+    vector<complex<float>> buffer; ///< Last taps.size() - 1 input samples followed by the block being filtered
+    uint32_t skip; ///< Input samples to consume before the next output
+    resamp_crcf resampler;
+};
+
+#endif // DECIMATOR_H
@@ -0,0 +1,103 @@
+#ifndef DECODE_SCHEDULER_H
+#define DECODE_SCHEDULER_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+
+namespace nr {
+  /**
+   * Time budget of the decode work of one CORESET occasion.
+   */
+  class decode_deadline {
+    public:
+      /**
+       * @param budget_us time budget from now, 0 for no deadline
+       */
+      explicit decode_deadline(uint32_t budget_us);
+
+      bool expired() const;
+
+    private:
+      bool unlimited;
+      std::chrono::steady_clock::time_point end;
+  };
+
+  /**
+   * Process-wide controller of the decode coverage in live operation. The lag
+   * is the wall time elapsed minus the sample time elapsed since the first
+   * chunk. While it exceeds the maximum lag the coverage level is raised one
+   * step at a time, and it is lowered again once the lag is below half of it.
+   * Each level halves the RNTIs tried per candidate, and the highest levels
+   * also skip the lowest aggregation levels.
+   */
+  class lag_controller {
+    public:
+      static constexpr int max_level = 4;
+
+      /**
+       * Copy of the controller state, to put the process-wide instance back
+       * as it was.
+       */
+      struct state {
+        uint32_t max_lag_ms = 0;
+        bool started = false;
+        double first_sample_time_s = 0;
+        std::chrono::steady_clock::time_point first_wall_time;
+        std::chrono::steady_clock::time_point last_change;
+        std::chrono::steady_clock::time_point last_report;
+        double lag_ms = 0;
+        int level = 0;
+      };
+
+      static lag_controller& instance();
+
+      /**
+       * @param max_lag_ms lag above which coverage is reduced, 0 to disable the controller
+       */
+      void configure(uint32_t max_lag_ms);
+
+      /**
+       * Updates the lag with the sample time of the chunk being processed.
+       */
+      void update(double sample_time_s);
+
+      /**
+       * Updates the lag as if the wall time was now.
+       */
+      void update(double sample_time_s, std::chrono::steady_clock::time_point now);
+
+      int get_level() const { return level; }
+      int rnti_list_length(int configured) const;
+      // Lowest aggregation level index that is still decoded
+      int min_agg_level() const;
+
+      /**
+       * Logs the lag and the shed work, at most once per second.
+       */
+      void report();
+
+      state save();
+      void restore(const state& saved);
+
+      // Candidates that were not decoded, or whose decoding was cut short, for lack of time
+      std::atomic<uint64_t> shed_candidates = 0;
+      std::atomic<uint64_t> truncated_candidates = 0;
+
+    private:
+      lag_controller() = default;
+
+      std::mutex mutex;
+      uint32_t max_lag_ms = 0;
+      bool started = false;
+      double first_sample_time_s = 0;
+      std::chrono::steady_clock::time_point first_wall_time;
+      std::chrono::steady_clock::time_point last_change;
+      std::chrono::steady_clock::time_point last_report;
+      double lag_ms = 0;
+      std::atomic<int> level = 0;
+  };
+}
+
+#endif // DECODE_SCHEDULER_H
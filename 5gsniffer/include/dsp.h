@@ -5,18 +5,52 @@
 #include <vector>
 #include <span>
 #include <cstdint>
+#include <liquid/liquid.h>
 
 using namespace std;
 
 void correlate(vector<complex<float>>& output, span<complex<float>> a, span<complex<float>> b);
 void correlate(vector<complex<float>>& output, span<complex<float>> a, span<complex<float>> b, int step_size);
 void moving_correlate(vector<complex<float>>& output, span<complex<float>> a, span<complex<float>> b, size_t window_size);
+void moving_correlate_delayed(vector<complex<float>>& output, span<const complex<float>> a, size_t delay, size_t window_size);
 void correlate_magnitude(vector<float>& output, span<complex<float>> a, span<complex<float>> b);
 void correlate_magnitude(vector<float>& output, span<complex<float>> a, span<complex<float>> b, int step_size);
 void correlate_magnitude_normalized(vector<float>& output, span<complex<float>> a, span<complex<float>> b);
+void correlate_magnitude_normalized_rows(vector<float>& output, span<const complex<float>> a, span<const float> matrix, span<const float> row_norms);
+void sliding_window_norms(vector<float>& output, span<const complex<float>> a, size_t window_size);
+void segment_norms(vector<float>& output, span<const complex<float>> a, span<const uint32_t> offsets);
+void correlate_segments_normalized(vector<float>& output, span<const complex<float>> a, span<const complex<float>> b, span<const uint32_t> offsets, span<const float> a_norms, span<const float> b_norms);
 void magnitude(vector<float>& output, span<complex<float>> input);
-float frobenius_norm(span<complex<float>> input);
+float frobenius_norm(span<const complex<float>> input);
 void rotate(vector<complex<float>>& output, span<complex<float>> input, float frequency, uint32_t sample_rate);
 
+/**
+ * Cross-correlation of a signal against a fixed set of references in the
+ * frequency domain, using overlap-save. The FFTs of the references are
+ * computed once, and every block of the signal is transformed once for all of
+ * them. Gives the same result as correlate() against each reference, in
+ * O(N log L) instead of O(N M) for references of length M and FFT size L.
+ */
+class overlap_save_correlator {
+  public:
+    /**
+     * @param references references of equal length to correlate against
+     */
+    explicit overlap_save_correlator(const vector<vector<complex<float>>>& references);
+
+    /**
+     * Correlation magnitudes of a against every reference, one output per
+     * reference of a.size() - M + 1 values each.
+     */
+    void correlate_magnitude(vector<vector<float>>& outputs, span<const complex<float>> a);
+
+    size_t get_fft_size() const { return fft_size; }
+
+  private:
+    size_t reference_length;
+    size_t fft_size;
+    vector<vector<complex<float>>> reference_ffts;
+    vector<float> magnitudes;
+};
 
 #endif // DSP_H
\ No newline at end of file
@@ -0,0 +1,110 @@
+#ifndef EXECUTOR_H
+#define EXECUTOR_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace nr {
+  class task_group;
+
+  /**
+   * Work-stealing thread pool. Every thread owns a task deque: tasks submitted
+   * from a pool thread go to the back of its own deque and are run newest
+   * first, idle threads steal the oldest tasks of the other deques. Tasks
+   * submitted from outside the pool are spread over the deques.
+   */
+  class executor {
+    public:
+      explicit executor(size_t num_threads);
+      ~executor();
+      executor(const executor&) = delete;
+      executor& operator=(const executor&) = delete;
+
+      /**
+       * Returns the process-wide executor, created with num_threads on first use
+       * so that all flows share the same threads.
+       */
+      static std::shared_ptr<executor> shared(size_t num_threads);
+
+      /**
+       * Queues a task, of group if it is given.
+       */
+      void submit(std::function<void()> task, const task_group* group = nullptr);
+
+      /**
+       * Runs one pending task on the calling thread, only among the tasks of
+       * group if it is given.
+       *
+       * @return false if there was no task to run
+       */
+      bool run_pending_task(const task_group* group = nullptr);
+
+      size_t get_num_threads() const { return threads.size(); }
+
+    private:
+      struct queued_task {
+        const task_group* group;
+        std::function<void()> run;
+      };
+
+      struct task_queue {
+        std::mutex mutex;
+        std::deque<queued_task> tasks;
+      };
+
+      bool pop_task(std::function<void()>& task, const task_group* group);
+      void worker_loop(size_t index);
+
+      std::vector<std::unique_ptr<task_queue>> queues;
+      std::vector<std::thread> threads;
+      std::atomic<size_t> next_queue = 0;
+      std::atomic<size_t> pending_tasks = 0;
+      std::atomic<bool> stop = false;
+
+      std::mutex sleep_mutex;
+      std::condition_variable sleep_cv;
+  };
+
+  /**
+   * Group of tasks that are waited on together. Without an executor, tasks are
+   * run inline as they are added. A thread waiting on the group keeps running
+   * the pending tasks of that group, so groups can be nested inside tasks of
+   * the same executor. It never picks up other tasks, such as those of other
+   * flows, so waits only nest as deep as the groups themselves. Once no task
+   * of the group is left queued, it sleeps until the running ones are done.
+   * Tasks are added to a group before it is waited on.
+   */
+  class task_group {
+    public:
+      explicit task_group(executor* exec);
+      ~task_group();
+
+      void run(std::function<void()> task);
+
+      /**
+       * Waits for all tasks of the group, rethrowing the first exception thrown
+       * by any of them.
+       */
+      void wait();
+
+    private:
+      void join();
+
+      executor* exec;
+      std::atomic<size_t> outstanding = 0;
+      std::mutex done_mutex;
+      std::condition_variable done_cv;
+      std::mutex error_mutex;
+      std::exception_ptr error;
+  };
+}
+
+#endif // EXECUTOR_H
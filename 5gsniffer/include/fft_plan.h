@@ -0,0 +1,67 @@
+#ifndef FFT_PLAN_H
+#define FFT_PLAN_H
+
+#include <complex>
+#include <cstddef>
+#include <span>
+#include <string>
+#include <vector>
+#ifdef HAVE_FFTW
+#include <fftw3.h>
+#else
+#include <liquid/liquid.h>
+#endif
+
+namespace nr {
+  /**
+   * FFT of a fixed size and direction, planned once on aligned input and
+   * output buffers of its own. Uses FFTW when built with it (HAVE_FFTW), and
+   * liquid otherwise. Neither direction is scaled.
+   *
+   * A plan can transform a batch of inputs at once, stored one after the
+   * other in its buffers, which FFTW plans as a single many-transform FFT.
+   *
+   * A plan is not thread-safe. get() hands out the plans of the calling
+   * thread, which are created on first use and kept for the lifetime of the
+   * thread, so no FFT is planned twice on a thread.
+   */
+  class fft_plan {
+    public:
+      fft_plan(size_t size, bool forward, size_t howmany = 1);
+      ~fft_plan();
+      fft_plan(const fft_plan&) = delete;
+      fft_plan& operator=(const fft_plan&) = delete;
+
+      /**
+       * The cached plan of the calling thread for size, direction and batch.
+       */
+      static fft_plan& get(size_t size, bool forward, size_t howmany = 1);
+
+      /**
+       * Loads FFTW wisdom from path if it exists, and from then on plans new
+       * FFTs by measuring and saves the wisdom to path after each, so the
+       * measuring is only paid for once. Plans are not measured if path
+       * cannot be written. Does nothing without FFTW.
+       */
+      static void load_wisdom(const std::string& path);
+
+      std::span<std::complex<float>> input() { return {in, n * howmany}; }
+      std::span<std::complex<float>> output() { return {out, n * howmany}; }
+      size_t size() const { return n; }
+      size_t batch() const { return howmany; }
+      void execute();
+
+    private:
+      size_t n;
+      size_t howmany;
+      std::complex<float>* in;
+      std::complex<float>* out;
+#ifdef HAVE_FFTW
+      fftwf_plan plan;
+#else
+      std::vector<fftplan> plans; ///< One per transform of the batch
+#endif
+  };
+}
+
+#endif // FFT_PLAN_H
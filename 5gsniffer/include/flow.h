@@ -22,6 +22,7 @@ class flow : public worker {
     virtual ~flow();
     // void process(shared_ptr<vector<complex<float>>>& samples) override;
     void process(shared_ptr<vector<complex<float>>>& samples, int64_t metadata) override;
+    void process(const sample_view& samples, int64_t metadata) override;
     void finish() override;
     void handle_messages();
     void set_available();
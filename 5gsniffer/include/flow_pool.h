@@ -22,7 +22,9 @@ namespace nr {
       flow_pool(uint64_t max_flows, const std::string& zmq_address);
       virtual ~flow_pool();
       void process(shared_ptr<vector<complex<float>>>& samples, int64_t metadata) override;
+      void process(const sample_view& samples, int64_t metadata) override;
       shared_ptr<flow> acquire_flow();
+      void release_flow(shared_ptr<flow> f);
       void release_flows();
     private:
       vector<shared_ptr<flow>> pool;
@@ -32,6 +34,24 @@ namespace nr {
       shared_ptr<counting_semaphore<>> available_flows;
       uint64_t max_flows;
   };
+
+  /**
+   * The flows acquired from a shared flow_pool by one user of the pool, e.g.
+   * the syncer of one cell. Samples are only sent to these flows, and
+   * releasing them leaves the flows of the other users running.
+   */
+  class flow_group : public worker {
+    public:
+      flow_group(shared_ptr<flow_pool> pool);
+      virtual ~flow_group();
+      void process(shared_ptr<vector<complex<float>>>& samples, int64_t metadata) override;
+      void process(const sample_view& samples, int64_t metadata) override;
+      shared_ptr<flow> acquire_flow();
+      void release_flows();
+    private:
+      shared_ptr<flow_pool> pool;
+      vector<shared_ptr<flow>> flows;
+  };
 }
 
 #endif // FLOW_POOL_H
\ No newline at end of file
@@ -0,0 +1,23 @@
+#ifndef GSCN_H
+#define GSCN_H
+
+#include <cstdint>
+#include <vector>
+
+namespace nr {
+  static constexpr uint32_t gscn_min = 2;
+  static constexpr uint32_t gscn_max = 26639;
+
+  /**
+   * SSB center frequency of a GSCN (TS 38.104 table 5.4.3.1-1), in Hz.
+   */
+  double gscn_to_frequency(uint32_t gscn);
+
+  /**
+   * GSCNs whose SSB of ssb_bandwidth Hz lies within the usable part of a
+   * capture, by increasing frequency.
+   */
+  std::vector<uint32_t> gscn_raster(double center_frequency, uint64_t sample_rate, double ssb_bandwidth);
+}
+
+#endif // GSCN_H
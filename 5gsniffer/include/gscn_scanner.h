@@ -0,0 +1,70 @@
+#ifndef GSCN_SCANNER_H
+#define GSCN_SCANNER_H
+
+#include <complex>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <vector>
+#include <srsran/srsran.h>
+#include "executor.h"
+#include "gscn.h"
+
+namespace nr {
+  /**
+   * Searches a wideband capture for cells at every GSCN raster position it
+   * covers. Each raster position is mixed to baseband and downsampled to the
+   * SSB rate, its cells are detected by PSS and SSS, and the PBCH of each cell
+   * is decoded. The raster positions are processed in parallel.
+   */
+  class gscn_scanner {
+    public:
+      struct channel {
+        uint32_t gscn;
+        double frequency;
+        double offset; ///< From the center of the capture
+      };
+
+      struct result {
+        uint32_t gscn;
+        double frequency;
+        uint16_t cell_id;
+        float snr_db; ///< Estimated from the SSS correlation
+        float cfo; ///< Fine CFO of the SSB, in Hz
+        bool mib_found;
+        srsran_mib_nr_t mib;
+      };
+
+      /**
+       * @param threshold minimum normalized PSS and SSS correlation of a cell
+       * @param num_threads threads processing raster positions
+       */
+      gscn_scanner(uint64_t sample_rate, double center_frequency, uint16_t ssb_numerology, float threshold, size_t num_threads);
+
+      /**
+       * Number of samples a scan needs to see an SSB of every cell.
+       */
+      size_t get_num_samples() const;
+      const std::vector<channel>& get_channels() const { return channels; }
+
+      /**
+       * Cells found in samples, by increasing frequency.
+       *
+       * @param nid_2 only report cells of this NID2, any for values above 2
+       */
+      std::vector<result> scan(std::span<std::complex<float>> samples, uint8_t nid_2 = 3);
+
+    private:
+      void scan_channel(const channel& ch, std::span<std::complex<float>> samples, uint8_t nid_2, std::vector<result>& results);
+      bool decode_mib(result& r, uint16_t nid1, uint8_t nid2, std::vector<std::complex<float>>& ssb);
+
+      uint64_t sample_rate;
+      uint16_t ssb_numerology;
+      uint64_t ssb_sample_rate;
+      float threshold;
+      std::vector<channel> channels;
+      std::unique_ptr<executor> exec;
+  };
+}
+
+#endif // GSCN_SCANNER_H
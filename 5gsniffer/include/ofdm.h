@@ -5,14 +5,18 @@
 #include <memory>
 #include <vector>
 #include <complex>
+#include <span>
 #include <liquid/liquid.h>
 #include "worker.h"
 #include "bandwidth_part.h"
+#include "slot_grid.h"
 
 using namespace std;
 
 /**
- * Class for OFDM modulation and demodulation.
+ * Class for OFDM modulation and demodulation. Demodulated symbols are passed
+ * on as a slot_grid of the subcarriers of the bandwidth part. Symbols that
+ * no next worker needs can be skipped without being transformed.
  */
 class ofdm : public worker {
   public:
@@ -23,11 +27,18 @@ class ofdm : public worker {
     virtual ~ofdm();
     void process(shared_ptr<vector<complex<float>>>& samples, int64_t metadata) override;
     vector<complex<float>> modulate(vector<symbol>& symbols);
+    void set_symbol_indices(span<const uint8_t> symbol_indices);
   private:
     shared_ptr<bandwidth_part> bwp;
     float cyclic_prefix_fraction;
     uint64_t samples_processed;
     std::vector<std::complex<float>> leftover_samples;
+    shared_ptr<slot_grid> grid;
+    uint32_t symbol_mask = ~0u; ///< Bit l is set if symbol l of the slot is demodulated
+
+    bool is_needed(uint8_t l) const { return (symbol_mask >> l) & 1; }
+
+    size_t demodulate(slot_grid& grid, span<const complex<float>> samples);
 
 
     string get_symbol_dump_path_name();
@@ -4,13 +4,51 @@
 #include "coreset.h"
 #include "dmrs.h"
 #include "dci.h"
+#include "pdcch_decoder_pool.h"
+#include "pdcch_dmrs_table.h"
+#include "pdcch_dmrs_cache.h"
+#include "executor.h"
+#include "rnti_recency.h"
+#include "decode_scheduler.h"
+#include "search_space_discovery.h"
 #include <cmath>
 #include "worker.h"
-#include <semaphore>
+#include <atomic>
+#include <mutex>
 #include <srsran/srsran.h>
 #include "srsran_exports.h"
 
 namespace nr {
+  /**
+   * Received DMRS REs of a symbol, laid out like the DMRS references so every
+   * scrambling ID is correlated in a single pass.
+   */
+  struct dmrs_correlation_batch {
+    std::vector<std::complex<float>> rx_dmrs;
+    std::vector<float> rx_norms;
+    std::vector<float> correlations;
+    std::vector<float> segment_correlation;
+  };
+
+  /**
+   * DCI decoded by a symbol task. It is reported, and its RNTI moved to the
+   * front of the RNTI list, once the symbols of the chunk are merged in order.
+   */
+  struct decoded_dci {
+    dci dci_;
+    std::vector<uint8_t> bits;
+    bool recovered; ///< RNTI recovered from the CRC rather than tried from the list
+  };
+
+  /**
+   * Decode coverage of a chunk, reduced by the lag controller when decoding
+   * falls behind.
+   */
+  struct decode_limits {
+    int rnti_list_length;
+    int min_agg_level; ///< Lowest aggregation level index that is decoded
+  };
+
   class pdcch : public worker {
 
     public:
@@ -28,6 +66,28 @@ namespace nr {
       // Used to compute the timing of found DCIs
       uint64_t sample_rate_time;
       int rnti_list_length;
+      // RNTIs not found for this long sink back to their initial position in the RNTI list, 0 to never age
+      uint32_t rnti_aging_ms;
+      // Time budget of the decode work of one CORESET occasion, 0 for no budget
+      uint32_t slot_budget_us;
+      // Recover the RNTI from the CRC when the PDCCH is scrambled with the cell ID
+      bool rnti_recovery;
+      uint8_t rnti_recovery_min_hits;
+      uint32_t rnti_recovery_window_ms;
+      // Solve for the DMRS scrambling ID before scanning the configured range
+      bool use_scrambling_id_solver;
+      // Memory cap of the DMRS reference cache, and whether upcoming references are generated in the background
+      uint32_t dmrs_cache_size_mb;
+      bool dmrs_prefetch;
+      // Search candidates from the largest AL down, pruning contained and low-energy candidates
+      bool hierarchical_search;
+      float hierarchical_energy_ratio;
+      // Search only the scrambling IDs and RNTI blocks found in a discovery window, with periodic full rescans
+      uint32_t discovery_ms;
+      uint32_t rescan_period_ms;
+      uint32_t rescan_ms;
+      // Pool running the symbols and candidates of a chunk in parallel, or nullptr to process them serially
+      std::shared_ptr<executor> task_executor;
 
       /*Constructor/Destructor*/
       pdcch();
@@ -46,8 +106,16 @@ namespace nr {
       }
       
       void initialize_RNTI_list();
+      void select_decode_rntis();
       bool update_RNTI_list(uint16_t found_RNTI);
       void initialize_dmrs_seq(); 
+      void generate_dmrs_symbols(std::vector<std::complex<float>>& output, std::span<const std::vector<std::complex<float>>> sequences, std::span<const uint16_t> pdcch_dmrs_rb_indices);
+      std::shared_ptr<pdcch_dmrs_references> generate_dmrs_references(uint16_t scrambling_id, uint8_t slot_index);
+      void gather_dmrs_batch(symbol& symbol, const pdcch_dmrs_references& layout, dmrs_correlation_batch& batch);
+      int search_candidates_hierarchically(uint8_t slot_index, const pdcch_dmrs_references& references, dmrs_correlation_batch& batch);
+      void correlate_deferred(symbol& symbol, std::vector<dci>& dcis);
+      // Correlation of a candidate whose correlation the hierarchical search deferred
+      static constexpr float deferred_correlation = -1.0f;
 
       std::vector<dci> get_found_dci_list_per_AL(uint8_t AL, std::vector<dci>& found_dci_list);
       void add_found_dci(dci dci_info_);
@@ -60,18 +128,35 @@ namespace nr {
     /*Aux function that finds candidates based on subcarriers where power was found*/
       std::vector<uint8_t> find_list_candidates(std::vector<uint16_t> occupied_subcarriers, uint8_t agg_level,uint8_t nSlot, bool user_search_space);
 
+    /*Recovers the DMRS scrambling ID of the strongest candidates in a symbol*/
+      bool solve_scrambling_id(symbol& symbol, uint16_t& scrambling_id);
+
     /*Function that correlates PDCCH DMRS*/
       bool correlate_DMRS(symbol& symbol, std::vector<dci>& found_dci_list);
 
     /*This overloaded version correlates DMRs with the decision from looking at the power per subcarrier*/
       bool correlate_DMRS(symbol& symbol,std::vector<uint8_t> list_candidates,uint8_t agg_level, std::vector<dci>& found_dci_list);
       // float compute_correlation_DMRS(symbol& symbol, std::vector<uint16_t> pdcch_dmrs_rb_indices, std::vector<uint64_t> pdcch_dmrs_sc_indices, std::vector<std::complex<float>> pdcch_dmrs_symbols_al_max);
-      float compute_correlation_DMRS(symbol& symbol, std::vector<std::complex<float>>& pdcch_dmrs_symbols, std::vector<uint64_t>& pdcch_dmrs_sc_indices);
+      float compute_correlation_DMRS(symbol& symbol, std::span<std::complex<float>> pdcch_dmrs_symbols, std::span<uint64_t> pdcch_dmrs_sc_indices);
+
+      void estimate_channel_dci(const symbol& symbol, const dci& dci_, std::vector<std::complex<float>>& pdcch_symbols);
 
-      std::vector<std::complex<float>> estimate_channel_dci(symbol& symbol, dci dci_);
+    /*Symbol and candidate tasks of process()*/
+      void process_symbol(symbol& symbol, int64_t metadata, const decode_limits& limits, std::vector<decoded_dci>& decoded);
+      bool decode_candidate(symbol& symbol, const dci& candidate, uint8_t AL, int64_t metadata, const decode_limits& limits, const decode_deadline& deadline, std::vector<decoded_dci>& decoded);
 
     /*PDCCH decoder*/
-    int decode_pdcch(symbol& symbol, std::vector<std::complex<float>>& pdcch_symbols, dci dci_, srsran_pdcch_nr_res_t* res, bool rep_opt, int64_t metadata, int symbol_in_chunk);
+    int decode_pdcch(std::vector<std::complex<float>>& pdcch_symbols, dci dci_, srsran_pdcch_nr_res_t* res, bool rep_opt, std::vector<decoded_dci>& decoded);
+
+    /*Decodes a candidate once and recovers the RNTI from the CRC parity*/
+    int recover_rnti_pdcch(std::vector<std::complex<float>>& pdcch_symbols, dci dci_, srsran_pdcch_nr_res_t* res, int64_t metadata, std::vector<decoded_dci>& decoded);
+      bool is_plausible_rnti(uint16_t rnti, int64_t metadata);
+      void confirm_rnti(uint16_t rnti, int64_t metadata);
+
+    /*Decoding stages shared by both decoders*/
+      pdcch_decoder_context& decode_pdcch_bits(std::vector<std::complex<float>>& pdcch_symbols, dci& dci_, srsran_pdcch_nr_res_t* res, bool rep_opt);
+      uint32_t compute_crc_syndrome(pdcch_decoder_context& ctx);
+      void report_dci(symbol& symbol, dci& dci_, uint8_t* c, int64_t metadata, int symbol_in_chunk);
 
     
     /*Util functions to generate PDCCH RB/SC indices, candidates, etc*/
@@ -93,17 +178,38 @@ namespace nr {
       
       uint32_t pdcch_nr_c_init_scrambler(uint16_t RNTI, uint16_t pdcch_scrambling_id);
 
-      std::unordered_map<string, std::vector<std::complex<float>> > dmrs_seq_table;
-
-      std::unordered_map<string, std::vector<uint64_t> > dmrs_sc_indices_table;
+      // Candidate geometry indexed by (slot, AL, candidate)
+      pdcch_dmrs_table dmrs_table;
 
-      std::unordered_map<string, std::vector<uint16_t> > data_sc_indices_table;
+      // DMRS references per (scrambling ID, slot), generated on first use
+      std::shared_ptr<pdcch_dmrs_cache> dmrs_cache;
 
 
     private:
+      // Number of strongest candidates tried by the scrambling ID solver
+      static constexpr int max_solver_candidates = 3;
+      // RNTIs tried between two deadline checks
+      static constexpr int deadline_check_interval = 64;
       uint16_t RNTI;
       coreset coreset_info;
-      std::vector<uint16_t> found_RNTI_list;
+      // RNTIs to try, most recently found first
+      rnti_recency rnti_list;
+      // Several flows process chunks through the same pdcch, the discovery and RNTI selection are guarded by discovery_mutex
+      std::mutex discovery_mutex;
+      // Scrambling IDs and RNTI blocks searched outside of full scans
+      search_space_discovery discovery;
+      // RNTIs tried in the chunks being processed, published like the snapshots of rnti_list
+      std::atomic<rnti_recency::snapshot_ptr> decode_rntis;
+      // Snapshot and RNTI blocks the decode RNTIs were filtered from
+      rnti_recency::snapshot_ptr filtered_rntis_source;
+      uint32_t filtered_rntis_version;
+      // Epoch of the latest chunk, in ms of sample time
+      std::atomic<uint32_t> rnti_epoch;
+      // RNTIs recovered from the CRC, guarded by recovery_mutex
+      std::mutex recovery_mutex;
+      std::vector<int64_t> RNTI_confirmed_at; ///< Sample index of the last confirmation, -1 if never
+      std::vector<uint8_t> recovered_RNTI_hits;
+      std::vector<int64_t> recovered_RNTI_last_seen;
 
       void write_pdcch_symbol_metadata(uint64_t sample_index, uint16_t scrambling_id, uint8_t aggregation_level, uint8_t candidate_idx, float correlation);
   };
@@ -0,0 +1,43 @@
+#ifndef PDCCH_DECODER_POOL_H
+#define PDCCH_DECODER_POOL_H
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <vector>
+#include <srsran/srsran.h>
+#include "srsran_exports.h"
+
+namespace nr {
+  /**
+   * Polar decoding context for a single (K, E) pair. Wraps an srsRAN PDCCH
+   * receiver that is initialized once and whose polar code construction is
+   * fetched once, so it can be reused for every RNTI and candidate trial with
+   * the same payload and rate-matched sizes.
+   */
+  class pdcch_decoder_context {
+    public:
+      pdcch_decoder_context(uint32_t K, uint32_t E);
+      ~pdcch_decoder_context();
+      pdcch_decoder_context(const pdcch_decoder_context&) = delete;
+      pdcch_decoder_context& operator=(const pdcch_decoder_context&) = delete;
+
+      srsran_pdcch_nr_t q;              ///< srsRAN receiver with K, M, E and code already set
+      std::vector<int8_t> llr_scratch;  ///< Scratch buffer of E LLRs used by the repetition optimization
+  };
+
+  /**
+   * Pool of decoding contexts keyed by (K, E). Contexts are built on first use
+   * and kept for the lifetime of the pool. The pool is not thread-safe; each
+   * flow thread owns its own pool so the decode path never locks.
+   */
+  class pdcch_decoder_pool {
+    public:
+      pdcch_decoder_context& get(uint32_t K, uint32_t E);
+      size_t size() const;
+    private:
+      std::map<uint64_t, std::unique_ptr<pdcch_decoder_context>> contexts;
+  };
+}
+
+#endif // PDCCH_DECODER_POOL_H
@@ -0,0 +1,98 @@
+#ifndef PDCCH_DMRS_CACHE_H
+#define PDCCH_DMRS_CACHE_H
+
+#include <complex>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace nr {
+  /**
+   * DMRS references of every candidate of a CORESET for one (scrambling ID, slot).
+   */
+  struct pdcch_dmrs_references {
+    std::vector<std::complex<float>> symbols;
+    std::vector<uint32_t> offsets; ///< Start of each (AL, candidate) in symbols, plus the end
+    std::vector<float> norms; ///< Frobenius norm of each (AL, candidate)
+    uint8_t max_candidates = 0;
+
+    std::span<std::complex<float>> get(uint8_t agg_level, uint8_t candidate_idx) const;
+    size_t memory_usage() const;
+  };
+
+  /**
+   * Lazily generated, memory-capped cache of DMRS references keyed by
+   * (scrambling ID, slot). References are generated on first use, the least
+   * recently used entries are evicted once the memory cap is exceeded, and a
+   * background thread can generate upcoming entries ahead of time.
+   * Entries are handed out as shared pointers, so eviction never invalidates
+   * references that are still in use.
+   */
+  class pdcch_dmrs_cache {
+    public:
+      using generator = std::function<std::shared_ptr<pdcch_dmrs_references>(uint16_t scrambling_id, uint8_t slot_index)>;
+
+      pdcch_dmrs_cache(generator generate, size_t capacity_bytes);
+      ~pdcch_dmrs_cache();
+      pdcch_dmrs_cache(const pdcch_dmrs_cache&) = delete;
+      pdcch_dmrs_cache& operator=(const pdcch_dmrs_cache&) = delete;
+
+      std::shared_ptr<const pdcch_dmrs_references> get(uint16_t scrambling_id, uint8_t slot_index);
+
+      /**
+       * Returns the cached references if there are any, and otherwise
+       * generates them without caching them. For scans over more references
+       * than fit in the cache, which would evict each entry before its reuse.
+       */
+      std::shared_ptr<const pdcch_dmrs_references> get_uncached(uint16_t scrambling_id, uint8_t slot_index);
+
+      /**
+       * Requests the references of a scrambling ID range for a slot to be
+       * generated in the background. Replaces any pending request, and stops
+       * early once the range would not fit in the cache.
+       */
+      void prefetch(uint16_t first_scrambling_id, uint16_t last_scrambling_id, uint8_t slot_index);
+
+      size_t size();
+      size_t memory_usage();
+      size_t get_capacity_bytes() const { return capacity_bytes; }
+
+    private:
+      struct entry {
+        std::shared_ptr<const pdcch_dmrs_references> references;
+        std::list<uint32_t>::iterator lru_position;
+      };
+      struct prefetch_request {
+        uint16_t first_scrambling_id;
+        uint16_t last_scrambling_id;
+        uint8_t slot_index;
+      };
+
+      static uint32_t key(uint16_t scrambling_id, uint8_t slot_index) { return (static_cast<uint32_t>(scrambling_id) << 8) | slot_index; }
+      std::shared_ptr<const pdcch_dmrs_references> insert(uint32_t k, std::shared_ptr<const pdcch_dmrs_references> references);
+      void prefetch_loop();
+
+      generator generate;
+      size_t capacity_bytes;
+      size_t used_bytes = 0;
+
+      std::mutex mutex;
+      std::unordered_map<uint32_t, entry> entries;
+      std::list<uint32_t> lru; ///< Most recently used first
+
+      std::condition_variable prefetch_cv;
+      std::optional<prefetch_request> pending_prefetch;
+      bool stop = false;
+      std::thread prefetch_thread;
+  };
+}
+
+#endif // PDCCH_DMRS_CACHE_H
@@ -0,0 +1,76 @@
+#ifndef PDCCH_DMRS_TABLE_H
+#define PDCCH_DMRS_TABLE_H
+
+#include <cstdint>
+#include <span>
+#include <vector>
+#include "phy_params_common.h"
+
+namespace nr {
+  /**
+   * Dense table of the PDCCH candidate geometry. Entries are indexed by
+   * (slot, aggregation level, candidate) and stored back to back in contiguous
+   * slabs, so lookups are an offset computation and return spans into the
+   * slabs without allocating.
+   */
+  class pdcch_dmrs_table {
+    public:
+      /**
+       * Clears the table and sizes it for a CORESET.
+       *
+       * @param num_slots number of slots per frame
+       * @param candidates_per_AL number of candidates for each aggregation level index
+       */
+      void reset(uint8_t num_slots, const std::vector<uint8_t>& candidates_per_AL);
+
+      /**
+       * Stores the geometry of a candidate.
+       *
+       * @param agg_level aggregation level index (log2 of the AL)
+       */
+      void add(uint8_t slot_index, uint8_t agg_level, uint8_t candidate_idx, const std::vector<uint64_t>& dmrs_sc_indices, const std::vector<uint16_t>& data_sc_indices, const std::vector<uint16_t>& dmrs_rb_indices);
+
+      bool contains(uint8_t slot_index, uint8_t agg_level, uint8_t candidate_idx) const;
+
+      /**
+       * Links every candidate to the higher-AL candidates of its slot whose DMRS
+       * REs include all of its own. Call once all candidates are added.
+       */
+      void link_parents();
+
+      /* Accessors return empty spans for candidates that are not in the table */
+      std::span<uint64_t> dmrs_sc_indices(uint8_t slot_index, uint8_t agg_level, uint8_t candidate_idx);
+      std::span<uint16_t> data_sc_indices(uint8_t slot_index, uint8_t agg_level, uint8_t candidate_idx);
+      std::span<uint16_t> dmrs_rb_indices(uint8_t slot_index, uint8_t agg_level, uint8_t candidate_idx);
+      /* Containing candidates, as agg_level * get_max_candidates() + candidate_idx */
+      std::span<const uint16_t> parents(uint8_t slot_index, uint8_t agg_level, uint8_t candidate_idx) const;
+
+      uint8_t get_num_slots() const { return num_slots; }
+      uint8_t get_max_candidates() const { return max_candidates; }
+
+    private:
+      struct entry {
+        bool valid = false;
+        uint32_t dmrs_sc_offset = 0;
+        uint32_t dmrs_sc_length = 0;
+        uint32_t data_sc_offset = 0;
+        uint32_t data_sc_length = 0;
+        uint32_t dmrs_rb_offset = 0;
+        uint32_t dmrs_rb_length = 0;
+        uint32_t parents_offset = 0;
+        uint32_t parents_length = 0;
+      };
+
+      const entry* find(uint8_t slot_index, uint8_t agg_level, uint8_t candidate_idx) const;
+
+      uint8_t num_slots = 0;
+      uint8_t max_candidates = 0;
+      std::vector<entry> entries;
+      std::vector<uint64_t> dmrs_sc_slab;
+      std::vector<uint16_t> data_sc_slab;
+      std::vector<uint16_t> dmrs_rb_slab;
+      std::vector<uint16_t> parents_slab;
+  };
+}
+
+#endif // PDCCH_DMRS_TABLE_H
@@ -15,7 +15,7 @@ using namespace std;
 namespace nr {
   class phy {
     public:
-      uint8_t nid1;
+      uint16_t nid1;
       uint16_t nid2;
       uint8_t i_ssb;
       uint8_t n_hf;
@@ -23,7 +23,6 @@ namespace nr {
       shared_ptr<bandwidth_part> ssb_bwp;                 ///< Special bandwidth part used for the SSB only
       vector<shared_ptr<bandwidth_part>> bandwidth_parts;
       vector<shared_ptr<channel_mapper>> channel_mappers;
-      std::array<std::array<std::complex<float>,sss_length>,nid_max+1> ssss;
 
       phy();
       uint16_t get_cell_id() const;
@@ -0,0 +1,72 @@
+#ifndef RNTI_RECENCY_H
+#define RNTI_RECENCY_H
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace nr {
+  /**
+   * Move-to-front ordering of the RNTIs to try when decoding. Promoting an
+   * RNTI is a single atomic store into a fixed 65536-slot array of stamps, and
+   * readers iterate an immutable snapshot of the order, so neither side locks.
+   * Snapshots are rebuilt by publish(): promoted RNTIs come first, most recent
+   * first, followed by the others in their initial order. RNTIs not promoted
+   * for more than max_age epochs sink back to their initial position.
+   */
+  class rnti_recency {
+    public:
+      using snapshot_ptr = std::shared_ptr<const std::vector<uint16_t>>;
+
+      rnti_recency();
+
+      /**
+       * Sets the RNTIs and their initial order, forgetting all promotions. Not
+       * safe to call concurrently with the other members.
+       */
+      void reset(const std::vector<uint16_t>& initial_order);
+
+      /**
+       * Moves an RNTI to the front of the next snapshot.
+       *
+       * @param epoch current epoch, used for aging
+       * @return false if the RNTI is not in the list
+       */
+      bool promote(uint16_t rnti, uint32_t epoch);
+
+      /**
+       * Publishes a new snapshot if RNTIs were promoted, or aged out, since the
+       * last one. Snapshots already handed out are not modified.
+       *
+       * @param epoch current epoch
+       */
+      void publish(uint32_t epoch);
+
+      snapshot_ptr snapshot() const { return current.load(std::memory_order_acquire); }
+
+      /* Number of epochs after which an RNTI that is not promoted again sinks back, 0 to never age */
+      void set_max_age(uint32_t max_age_) { max_age = max_age_; }
+
+    private:
+      static constexpr size_t num_rntis = 1 << 16;
+
+      bool is_aged(uint64_t stamp, uint32_t epoch) const;
+
+      std::vector<std::atomic<uint64_t>> stamps; ///< Epoch in the high word, promotion sequence in the low word, 0 if never promoted
+      std::vector<std::atomic<uint64_t>> touched; ///< Bitmap of the RNTIs promoted since the last snapshot
+      std::vector<uint16_t> initial_order;
+      std::vector<uint8_t> members;
+      std::atomic<uint32_t> sequence = 0;
+      uint32_t max_age = 0;
+
+      std::mutex publish_mutex;
+      // Promoted RNTIs of the last snapshot, guarded by publish_mutex
+      std::vector<uint16_t> promoted;
+      std::vector<uint8_t> is_promoted;
+      std::atomic<snapshot_ptr> current;
+  };
+}
+
+#endif // RNTI_RECENCY_H
@@ -0,0 +1,42 @@
+#ifndef SAMPLE_VIEW_H
+#define SAMPLE_VIEW_H
+
+#include <complex>
+#include <cstddef>
+#include <memory>
+#include <span>
+#include <vector>
+
+using namespace std;
+
+/**
+ * A range of samples within a reference-counted buffer. Handing a view to
+ * another worker shares the buffer instead of copying the samples, and
+ * dropping or delaying samples only changes the range.
+ */
+struct sample_view {
+  shared_ptr<vector<complex<float>>> buffer;
+  size_t offset = 0;
+  size_t length = 0;
+
+  sample_view() = default;
+  sample_view(shared_ptr<vector<complex<float>>> buffer, size_t offset, size_t length);
+
+  /**
+   * View of a whole buffer.
+   */
+  explicit sample_view(shared_ptr<vector<complex<float>>> buffer);
+
+  /**
+   * View of num_samples zeros, from a buffer shared by all zero views of the
+   * calling thread.
+   */
+  static sample_view zeros(size_t num_samples);
+
+  span<complex<float>> samples() const { return {buffer->data() + offset, length}; }
+  size_t size() const { return length; }
+  bool empty() const { return length == 0; }
+  bool is_whole() const { return offset == 0 && length == buffer->size(); }
+};
+
+#endif // SAMPLE_VIEW_H
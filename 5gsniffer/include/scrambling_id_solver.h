@@ -0,0 +1,50 @@
+#ifndef SCRAMBLING_ID_SOLVER_H
+#define SCRAMBLING_ID_SOLVER_H
+
+#include <cstdint>
+#include <complex>
+#include <vector>
+#include "phy_params_common.h"
+
+namespace nr {
+  /**
+   * Recovers the PDCCH DMRS scrambling ID (n_ID) from received DMRS symbols.
+   * The Gold sequence of TS 38.211 5.2.1 is linear over GF(2) in the x2 state,
+   * which is c_init, and x1 is fixed. Hard decisions on the DMRS REs therefore
+   * give a linear system whose solution is c_init, and c_init is affine in n_ID
+   * for a given slot and OFDM symbol (TS 38.211 7.4.1.3.1).
+   */
+  class scrambling_id_solver {
+    public:
+      /**
+       * Solves for c_init from observed Gold sequence bits.
+       *
+       * @param positions index n of each observed bit c(n)
+       * @param bits observed bit values
+       * @param reliability per-bit reliability, most reliable bits are used to solve
+       * @param c_init solved 31-bit c_init
+       * @return true if a solution agrees with enough of the observed bits
+       */
+      static bool solve_c_init(const std::vector<uint32_t>& positions, const std::vector<uint8_t>& bits, const std::vector<float>& reliability, uint32_t& c_init);
+
+      /**
+       * Inverts the PDCCH DMRS c_init for the scrambling ID.
+       *
+       * @return true if c_init corresponds to a valid 16-bit n_ID
+       */
+      static bool c_init_to_n_id(uint32_t c_init, uint8_t n_slot, uint8_t n_ofdm, uint8_t num_symbols_per_slot, uint16_t& n_id);
+
+      /**
+       * Proposes n_ID from the received DMRS symbols of one OFDM symbol. The
+       * channel phase is removed with a fourth-power estimate that is tracked
+       * across RBs, and the four QPSK rotations are tried in turn.
+       *
+       * @param rx_dmrs received DMRS REs, ordered by subcarrier
+       * @param seq_indices QPSK index m of each RE within the DMRS sequence
+       * @param n_id proposed scrambling ID
+       */
+      static bool solve(const std::vector<std::complex<float>>& rx_dmrs, const std::vector<uint16_t>& seq_indices, uint8_t n_slot, uint8_t n_ofdm, uint8_t num_symbols_per_slot, uint16_t& n_id);
+  };
+}
+
+#endif // SCRAMBLING_ID_SOLVER_H
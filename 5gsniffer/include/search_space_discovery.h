@@ -0,0 +1,71 @@
+#ifndef SEARCH_SPACE_DISCOVERY_H
+#define SEARCH_SPACE_DISCOVERY_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace nr {
+  /**
+   * Two-phase search over the scrambling IDs and RNTIs of a PDCCH. During a
+   * discovery window at the start of the capture the whole configured range
+   * is searched, and the scrambling IDs and RNTI blocks of the decoded DCIs
+   * are recorded. Afterwards only those are searched, except during a short
+   * full rescan at the end of every rescan period, which picks up new ones.
+   * It is not thread-safe: several flows decode through the same pdcch, which
+   * guards it with a mutex.
+   */
+  class search_space_discovery {
+    public:
+      static constexpr uint32_t rnti_block_size = 256;
+
+      search_space_discovery();
+
+      /**
+       * @param discovery_ms length of the discovery window, 0 to always search the whole range
+       * @param rescan_period_ms period of the full rescans, 0 to never rescan
+       * @param rescan_ms length of each full rescan
+       */
+      void configure(uint32_t discovery_ms, uint32_t rescan_period_ms, uint32_t rescan_ms);
+
+      /**
+       * Updates the phase with the sample time of the chunk to decode.
+       */
+      void update(uint32_t time_ms);
+
+      /**
+       * Records the scrambling ID and RNTI block of a decoded DCI.
+       */
+      void record(uint16_t scrambling_id, uint16_t rnti);
+
+      /* True while the whole configured range is searched */
+      bool is_full_scan() const { return full_scan; }
+
+      bool restricts_scrambling_ids() const { return !full_scan && !scrambling_ids.empty(); }
+      bool restricts_rntis() const { return !full_scan && num_rnti_blocks > 0; }
+
+      /* Scrambling IDs recorded so far, in ascending order */
+      const std::vector<uint16_t>& get_scrambling_ids() const { return scrambling_ids; }
+      bool contains_rnti(uint16_t rnti) const { return rnti_blocks[rnti / rnti_block_size]; }
+      size_t get_num_rnti_blocks() const { return num_rnti_blocks; }
+
+      /* Changes whenever an RNTI block is recorded */
+      uint32_t get_rnti_blocks_version() const { return rnti_blocks_version; }
+
+    private:
+      uint32_t discovery_ms = 0;
+      uint32_t rescan_period_ms = 0;
+      uint32_t rescan_ms = 0;
+
+      bool started = false;
+      uint32_t start_ms = 0;
+      bool full_scan = true;
+
+      std::vector<uint16_t> scrambling_ids;
+      std::vector<uint8_t> rnti_blocks;
+      size_t num_rnti_blocks = 0;
+      uint32_t rnti_blocks_version = 0;
+  };
+}
+
+#endif // SEARCH_SPACE_DISCOVERY_H
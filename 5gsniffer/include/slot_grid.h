@@ -0,0 +1,62 @@
+#ifndef SLOT_GRID_H
+#define SLOT_GRID_H
+
+#include <complex>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+#include "symbol.h"
+
+using namespace std;
+
+/**
+ * Resource grid of consecutive OFDM symbols, stored row by row in a single
+ * [symbols x subcarriers] buffer. Rows are views into the buffer, and a grid
+ * is cleared without freeing it, so it can be filled again for the next
+ * chunk without allocating.
+ */
+struct slot_grid {
+  struct symbol_info {
+    uint64_t sample_index;
+    uint8_t symbol_index; ///< Index of the symbol in the slot
+    uint8_t slot_index;   ///< Index of the slot in the frame
+  };
+
+  size_t num_subcarriers = 0;
+  vector<complex<float>> res;
+  vector<symbol_info> symbols;
+
+  /**
+   * Removes all symbols, keeping the memory, for symbols of num_subcarriers REs.
+   */
+  void reset(size_t num_subcarriers);
+
+  /**
+   * Makes room for num_symbols symbols.
+   */
+  void reserve(size_t num_symbols);
+
+  /**
+   * Appends a symbol and returns its row, to be filled by the caller.
+   */
+  span<complex<float>> add_symbol(const symbol_info& info);
+
+  size_t size() const { return symbols.size(); }
+  bool empty() const { return symbols.empty(); }
+  span<complex<float>> row(size_t i) { return {res.data() + i * num_subcarriers, num_subcarriers}; }
+  span<const complex<float>> row(size_t i) const { return {res.data() + i * num_subcarriers, num_subcarriers}; }
+
+  /**
+   * REs of count consecutive rows from row i, as one view.
+   */
+  span<const complex<float>> rows(size_t i, size_t count) const { return {res.data() + i * num_subcarriers, count * num_subcarriers}; }
+
+  /**
+   * Copy of count consecutive rows from row i as a single symbol, for
+   * workers that process symbols. It carries the indices of row i.
+   */
+  symbol to_symbol(size_t i, size_t count = 1) const;
+};
+
+#endif // SLOT_GRID_H
@@ -23,6 +23,7 @@ class ssb_mapper : public worker {
     // Callbacks
     std::function<void(uint16_t)> on_sss_found = [](uint16_t nid1) {}; ///< Default callback when SSS is found: do nothing
     std::function<void(void)> on_sss_not_found = [](){}; ///< Callback when SSS is not found
+    bool joint_nid2 = false; ///< Detect the NID2 jointly with the NID1 from the SSS, instead of trusting the NID2 of the PSS
 
     ssb_mapper(shared_ptr<nr::phy> phy);
     virtual ~ssb_mapper();
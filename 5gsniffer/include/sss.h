@@ -8,6 +8,8 @@
 #include <algorithm>
 #include <utility>
 #include <memory>
+#include <span>
+#include <vector>
 #include "common_checks.h"
 
 class sss
@@ -45,4 +47,29 @@ private:
   std::array <std::complex<float>,ssb_nfft>  sss_seq_t;
 };
 
+/**
+ * The SSS of every cell ID as the rows of a matrix, generated once and shared
+ * read-only. The SSS is BPSK, so the rows are real. The rows of a NID2 are
+ * contiguous, so detecting the NID1 of a known NID2, or jointly the NID1 and
+ * NID2, is a single matrix-vector product.
+ */
+class sss_table
+{
+public:
+  static const sss_table& get();
+
+  std::span<const float> get_sss_seq(uint16_t nid_1, uint8_t nid_2) const;
+
+  /* Normalized correlation of the SSS REs against every NID1 of nid_2, indexed by NID1 */
+  void correlate(std::vector<float>& correlations, std::span<const std::complex<float>> sss_res, uint8_t nid_2) const;
+
+  /* Normalized correlation of the SSS REs against every cell ID, indexed by nid_2 * (nid_1_max + 1) + nid_1 */
+  void correlate_all(std::vector<float>& correlations, std::span<const std::complex<float>> sss_res) const;
+
+private:
+  sss_table();
+  std::vector<float> matrix; ///< Row nid_2 * (nid_1_max + 1) + nid_1 is the SSS of that cell
+  std::vector<float> norms;
+};
+
 #endif
\ No newline at end of file
@@ -41,6 +41,7 @@ class symbol {
     bool is_equalized;
     vector<complex<float>> channel_filter;
     void channel_estimate(const vector<complex<float>>& dmrs_reference, const vector<uint64_t>& dmrs_indices, uint64_t subcarrier_start, uint64_t subcarrier_end);
+    void equalize_res(vector<complex<float>>& output, span<const complex<float>> dmrs_reference, span<const uint64_t> dmrs_indices, span<const uint16_t> data_indices) const;
     float get_average_noise_magnitude() const;
     float get_average_magnitude() const;
     float get_average_channel_magnitude() const;
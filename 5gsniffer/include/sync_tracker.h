@@ -0,0 +1,103 @@
+#ifndef SYNC_TRACKER_H
+#define SYNC_TRACKER_H
+
+#include <cstddef>
+#include <cstdint>
+
+namespace nr {
+  /**
+   * Placement of the downsampled PSS search window around the expected PSS
+   * position in the full-rate samples, and the mapping of a lag in the window
+   * back to a full-rate position. The filter group delay is compensated, so
+   * a PSS at its expected position peaks within a sample of lag margin, in
+   * the middle of the lags searched.
+   */
+  struct pss_window {
+    /**
+     * @param expected_pss expected start of the useful part of the PSS, in full-rate samples
+     * @param margin downsampled samples searched either side of the expected PSS
+     * @param window_length downsampled samples of the window
+     * @param resampling_rate output rate over input rate of the downsampler
+     * @param delay group delay of the downsampler, in input samples
+     */
+    pss_window(double expected_pss, size_t margin, size_t window_length, float resampling_rate, unsigned int delay);
+
+    /**
+     * Full-rate position of a PSS found at a (fractional) lag of the window.
+     */
+    double position(double lag) const;
+
+    int64_t input_start;  ///< First full-rate sample to downsample
+    int64_t input_length; ///< Full-rate samples to downsample
+    size_t transient;     ///< Downsampled samples before the window, whose filter reaches before the input
+
+    private:
+      float resampling_rate;
+      unsigned int delay;
+  };
+
+  /**
+   * Timing and CFO tracking loops of a synchronized cell, updated once per SSB
+   * from the PSS timing error and the CP-based CFO residual. Timing is a
+   * second-order DLL: the correction is proportional to the error, plus a
+   * drift term integrating it (sample clock offset). It is applied in whole
+   * samples, and the fraction is carried to the next SSB. The CFO is a
+   * first-order FLL. The lock is lost after a number of consecutive SSBs
+   * without a usable measurement.
+   */
+  class sync_tracker {
+    public:
+      /**
+       * @param timing_gain fraction of the timing error corrected at each SSB
+       * @param drift_gain fraction of the timing error integrated into the drift
+       * @param cfo_gain fraction of the CFO residual corrected at each SSB
+       * @param min_correlation normalized PSS correlation below which a measurement is rejected
+       * @param max_misses consecutive SSBs without a measurement before the lock is lost
+       */
+      sync_tracker(float timing_gain = 0.5f, float drift_gain = 0.05f, float cfo_gain = 0.5f, float min_correlation = 0.2f, uint32_t max_misses = 3);
+
+      /**
+       * Starts tracking from an acquisition, with no timing error or drift.
+       */
+      void reset(float cfo);
+
+      /**
+       * Updates the loops with the measurements of one SSB.
+       *
+       * @param timing_error PSS position minus its expected position, in samples
+       * @param cfo_error residual CFO in Hz
+       * @param correlation normalized PSS correlation at the measured position
+       * @return false if the measurement was rejected and counted as a miss
+       */
+      bool update(float timing_error, float cfo_error, float correlation);
+
+      /**
+       * Counts an SSB without a measurement. The drift is still applied.
+       */
+      void miss();
+
+      /**
+       * Returns the whole samples to drop (positive) or insert (negative) to
+       * apply the timing correction, and removes them from the loop.
+       */
+      int64_t take_slip();
+
+      float get_cfo() const { return cfo; }
+      float get_drift() const { return drift; }
+      bool is_locked() const { return misses < max_misses; }
+
+    private:
+      float timing_gain;
+      float drift_gain;
+      float cfo_gain;
+      float min_correlation;
+      uint32_t max_misses;
+
+      float cfo = 0;
+      float drift = 0; ///< Timing drift in samples per SSB
+      float correction = 0; ///< Timing correction not applied yet, in samples
+      uint32_t misses = 0;
+  };
+}
+
+#endif // SYNC_TRACKER_H
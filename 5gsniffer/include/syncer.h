@@ -12,6 +12,9 @@
 #include "sss.h"
 #include "phy.h"
 #include "flow_pool.h"
+#include "dsp.h"
+#include "decimator.h"
+#include "sync_tracker.h"
 #include <srsran/srsran.h>
 
 using namespace std;
@@ -23,14 +26,26 @@ class syncer : public worker {
   public:
     // MHZ - Pass zmq_address
     syncer(uint64_t sample_rate, shared_ptr<nr::phy> phy, const std::string& zmq_address);
+    /**
+     * Syncer of one of several cells of a capture, locked to a NID2, whose
+     * flows are acquired from a shared pool. With copy_input, the input
+     * samples are shared with other workers and not modified.
+     */
+    syncer(uint64_t sample_rate, shared_ptr<nr::phy> phy, shared_ptr<nr::flow_pool> flow_pool, uint8_t nid_2, bool copy_input);
     virtual ~syncer();
     void process(shared_ptr<vector<complex<float>>>& samples, int64_t metadata) override;
+    void expect_cell(uint16_t nid1, int64_t slot_start, size_t num_samples);
+    bool is_synchronized() const;
   private:
     void downsample(uint64_t num_samples, int64_t start_sample, int64_t end_sample);
     void fine_sync();
     void find_pss();
     void find_sss();
     void fine_time_sync();
+    void track();
+    void build_pss_correlator();
+    size_t queue_size() const;
+    void relay_queue();
 
     std::string zmq_address;
 
@@ -44,22 +59,32 @@ class syncer : public worker {
 
     uint64_t sample_rate;
     shared_ptr<nr::phy> phy;
-    enum class state { find_pss, fine_sync, find_sss, wait, reset, relay } state;
+    enum class state { find_pss, fine_sync, find_sss, wait, track, reset, relay } state;
     vector<pss> psss;
+    // Frequency-domain correlator against the PSS of pss_start..pss_end
+    unique_ptr<overlap_save_correlator> pss_correlator;
     sss ssss;
-    vector<complex<float>> processing_queue;
+    // Current chunk of samples. Samples before queue_start were already sent or dropped, and queue_zeros zeros are sent before the rest.
+    shared_ptr<vector<complex<float>>> processing_queue;
+    size_t queue_start;
+    size_t queue_zeros;
     vector<complex<float>> downsampled_samples;
-    resamp_crcf resampler;
+    unique_ptr<decimator> downsampler;
     float resampling_rate;
-    uint32_t max_resampled_samples_per_sample;
     float cfo;
     float new_cfo_fine;
+    // Timing and CFO loops updated from each SSB once synchronized
+    nr::sync_tracker tracker;
     int64_t sss_hint;
     uint64_t mib_id;
     int waiting_for_pss;
     int64_t counting_samples;
     float ssb_period;
-    shared_ptr<nr::flow_pool> flow_pool;
+    // Flows of this syncer, acquired from its flow pool
+    shared_ptr<nr::flow_group> flows;
+    bool copy_input;
+    // NID1 of the cell this syncer was created for, -1 for any cell
+    int32_t expected_nid1;
     uint8_t pss_start;
     uint8_t pss_end;
     int pss_window_size;
@@ -6,6 +6,8 @@
 #include <complex>
 #include <memory>
 #include "symbol.h"
+#include "sample_view.h"
+#include "slot_grid.h"
 #include "exceptions.h"
 
 using namespace std;
@@ -22,6 +24,8 @@ class worker {
     virtual ~worker();
     virtual void process(shared_ptr<vector<complex<float>>>& samples, int64_t metadata) { throw sniffer_exception("Tried to call worker::process directly"); };
     virtual void process(shared_ptr<vector<symbol>>& symbols, int64_t metadata) { throw sniffer_exception("Tried to call worker::process directly"); };
+    virtual void process(const sample_view& samples, int64_t metadata);
+    virtual void process(const shared_ptr<slot_grid>& grid, int64_t metadata);
     virtual shared_ptr<vector<complex<float>>> produce_samples(size_t num_samples);
     virtual shared_ptr<vector<symbol>> produce_symbols(size_t num_symbols);
     virtual void finish();
@@ -63,6 +67,8 @@ class worker {
         worker->work(inputs,metadata);
       }
     }
+    void send_to_next_workers(const sample_view& samples, int64_t metadata);
+    void send_to_next_workers(const shared_ptr<slot_grid>& grid, int64_t metadata);
 
     bool finished;
     int64_t total_produced_samples;
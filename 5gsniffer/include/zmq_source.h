@@ -0,0 +1,29 @@
+#ifndef ZMQ_SOURCE_H
+#define ZMQ_SOURCE_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <complex>
+#include <memory>
+#include <zmq.hpp>
+#include "worker.h"
+
+using namespace std;
+
+/**
+ * A sample_worker that produces complex samples received from a ZMQ publisher,
+ * as a stand-in for an SDR. Every message holds raw complex float samples.
+ */
+class zmq_source : public worker {
+  public:
+    zmq_source(const string& address);
+    virtual ~zmq_source();
+    shared_ptr<vector<complex<float>>> produce_samples(size_t num_samples) override;
+  private:
+    zmq::context_t ctx;
+    zmq::socket_t socket;
+    vector<complex<float>> leftover_samples; ///< Samples of the last message that did not fit in the last buffer
+};
+
+#endif // ZMQ_SOURCE_H
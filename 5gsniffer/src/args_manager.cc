@@ -3,48 +3,82 @@
 #include <iostream>
 #include <unistd.h>
 #include <cstdio>
+#include <thread>
 
 using namespace std;
 
 void args_manager::default_args(args_t& args) {
   args.force_N_id_2 = -1;
   args.input_file_name = "";
+  args.zmq_address = "";
   args.rf_args = "";
   args.rf_dev = "";
   args.rf_freq = -1.0;
   args.rf_gain = -1.0;
+  args.sample_rate = 23040000;
+  args.ssb_numerology = 0;
+  args.threshold = 0.3;
+  args.num_threads = std::thread::hardware_concurrency();
+  args.fft_wisdom_path = "fftw_wisdom";
 }
 
 void args_manager::usage(args_t& args, const std::string& prog) {
-  printf("Usage: %s [afgil] -f rx_frequency (in Hz) | -i input_file\n", prog.c_str());
+  printf("Usage: %s [adgilnstjwz] -f center_frequency (in Hz)\n", prog.c_str());
   printf("\t-h show this help message\n");
   printf("\t-a RF args [Default %s]\n", args.rf_args.c_str());
-  printf("\t-f Set RX freq [Default %.1f Hz]\n", args.rf_freq);
+  printf("\t-f Set RX freq, the center of the input file or stream [Default %.1f Hz]\n", args.rf_freq);
   printf("\t-g Set RX gain [Default %.1f dB]\n", args.rf_gain);
   printf("\t-d RF devicename [Default %s]\n", args.rf_dev.c_str());
   printf("\t-i input_file [Default use RF board]\n");
+  printf("\t-z ZMQ address of an IQ publisher, instead of the RF board [Default %s]\n", args.zmq_address.c_str());
+  printf("\t-s sample rate [Default %lu Hz]\n", args.sample_rate);
+  printf("\t-n SSB numerology [Default %u]\n", args.ssb_numerology);
+  printf("\t-t PSS and SSS correlation threshold [Default %.2f]\n", args.threshold);
+  printf("\t-j number of threads [Default %u]\n", args.num_threads);
   printf("\t-l Force N_id_2 [Default find best]\n");
+  printf("\t-w FFTW wisdom file, empty to not use one [Default %s]\n", args.fft_wisdom_path.c_str());
 }
 
 void args_manager::parse_args(args_t& args, int argc, char **argv) {
   int opt;
   default_args(args);
-  while ((opt = getopt(argc, argv, "afgil")) != -1) {
+  while ((opt = getopt(argc, argv, "a:d:f:g:i:j:l:n:s:t:w:z:h")) != -1) {
     switch (opt) {
       case 'a':
-        args.rf_args = argv[optind];
+        args.rf_args = optarg;
+        break;
+      case 'd':
+        args.rf_dev = optarg;
         break;
       case 'i':
-        args.input_file_name = argv[optind];
+        args.input_file_name = optarg;
+        break;
+      case 'z':
+        args.zmq_address = optarg;
         break;
       case 'l':
-        args.force_N_id_2 = atoi(argv[optind]);
+        args.force_N_id_2 = atoi(optarg);
         break;
       case 'f':
-        args.rf_freq = strtod(argv[optind], nullptr);
+        args.rf_freq = strtod(optarg, nullptr);
         break;
       case 'g':
-        args.rf_gain = strtod(argv[optind], nullptr);
+        args.rf_gain = strtod(optarg, nullptr);
+        break;
+      case 's':
+        args.sample_rate = strtoull(optarg, nullptr, 10);
+        break;
+      case 'n':
+        args.ssb_numerology = atoi(optarg);
+        break;
+      case 't':
+        args.threshold = strtof(optarg, nullptr);
+        break;
+      case 'j':
+        args.num_threads = atoi(optarg);
+        break;
+      case 'w':
+        args.fft_wisdom_path = optarg;
         break;
       case 'h':
       default:
@@ -53,7 +87,8 @@ void args_manager::parse_args(args_t& args, int argc, char **argv) {
     }
   }
 
-  if (args.rf_freq < 0 && args.input_file_name == "") {
+  // The raster positions are relative to the center frequency, also for files and streams
+  if (args.rf_freq < 0) {
     usage(args, argv[0]);
     exit(-1);
   }
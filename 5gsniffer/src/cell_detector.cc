@@ -0,0 +1,104 @@
+#include "cell_detector.h"
+#include "fft_plan.h"
+#include "pss.h"
+#include "sss.h"
+#include <algorithm>
+#include <spdlog/spdlog.h>
+
+namespace nr {
+  cell_detector::cell_detector(float threshold, size_t max_cells, size_t cp_length) :
+    threshold(threshold),
+    max_cells(max_cells),
+    sss_offset(2 * (ssb_nfft + cp_length)),
+    sss_res(sss_length) {
+    std::vector<std::vector<std::complex<float>>> pss_references;
+    for (uint8_t nid2 = 0; nid2 <= nid_2_max; nid2++) {
+      auto pss_seq_t = pss(nid2).get_pss_seq_t();
+      pss_references.emplace_back(pss_seq_t.begin(), pss_seq_t.end());
+      pss_norms.push_back(frobenius_norm(pss_references.back()));
+    }
+    pss_correlator = std::make_unique<overlap_save_correlator>(pss_references);
+  }
+
+  /**
+   * Normalized correlation of the SSS REs of an OFDM symbol (useful part only)
+   * against the SSS of every NID1 with the given NID2.
+   */
+  void cell_detector::correlate_sss(std::vector<float>& correlations, std::span<const std::complex<float>> symbol, uint8_t nid2) {
+    fft_plan& fft = fft_plan::get(ssb_nfft, true);
+    std::copy(symbol.begin(), symbol.begin() + ssb_nfft, fft.input().begin());
+    fft.execute();
+    auto fft_output = fft.output();
+
+    // The SSS is centered, its first RE is 64 subcarriers below DC
+    for (size_t j = 0; j < sss_length; j++) {
+      sss_res[j] = fft_output[(j + ssb_nfft - 64) % ssb_nfft];
+    }
+
+    sss_table::get().correlate(correlations, sss_res, nid2);
+  }
+
+  void cell_detector::detect(std::vector<detection>& detections, std::span<const std::complex<float>> samples) {
+    detections.clear();
+    if (samples.size() < sss_offset + ssb_nfft) {
+      return;
+    }
+
+    std::vector<std::vector<float>> correlations;
+    pss_correlator->correlate_magnitude(correlations, samples);
+    std::vector<float> window_norms;
+    sliding_window_norms(window_norms, samples, ssb_nfft);
+
+    // Only positions whose SSS is in the samples as well
+    size_t num_positions = samples.size() - sss_offset - ssb_nfft + 1;
+    std::vector<float> pss_correlation(num_positions);
+    std::vector<float> sss_correlations;
+    for (uint8_t nid2 = 0; nid2 <= nid_2_max; nid2++) {
+      for (size_t i = 0; i < num_positions; i++) {
+        float norm = window_norms[i] * pss_norms[nid2];
+        pss_correlation[i] = norm > 0 ? correlations[nid2][i] / norm : 0;
+      }
+
+      // PSS peaks: the strongest position within a symbol of each other
+      std::vector<size_t> peaks;
+      for (size_t i = 0; i < num_positions; i++) {
+        if (pss_correlation[i] < threshold) {
+          continue;
+        }
+        size_t start = i >= ssb_nfft ? i - ssb_nfft : 0;
+        size_t end = std::min(i + ssb_nfft + 1, num_positions);
+        if (std::max_element(pss_correlation.begin() + start, pss_correlation.begin() + end) == pss_correlation.begin() + i) {
+          peaks.push_back(i);
+        }
+      }
+
+      for (size_t peak : peaks) {
+        correlate_sss(sss_correlations, samples.subspan(peak + sss_offset, ssb_nfft), nid2);
+        for (uint16_t nid1 = 0; nid1 <= nid_1_max; nid1++) {
+          if (sss_correlations[nid1] >= threshold) {
+            detections.push_back({nid1, nid2, peak, pss_correlation[peak], sss_correlations[nid1]});
+          }
+        }
+      }
+    }
+
+    // A cell can be found at several PSS peaks, e.g. of two SSBs. Keep its strongest.
+    std::sort(detections.begin(), detections.end(), [](const detection& a, const detection& b) {
+      return a.sss_correlation > b.sss_correlation;
+    });
+    std::vector<detection> unique_detections;
+    for (const detection& d : detections) {
+      bool found = std::any_of(unique_detections.begin(), unique_detections.end(), [&d](const detection& u) {
+        return u.get_cell_id() == d.get_cell_id();
+      });
+      if (!found && unique_detections.size() < max_cells) {
+        unique_detections.push_back(d);
+      }
+    }
+    detections = std::move(unique_detections);
+
+    for (const detection& d : detections) {
+      SPDLOG_DEBUG("[CELLS] Detected cell ID {} (NID1 {}, NID2 {}) at {}, PSS corr {} SSS corr {}", d.get_cell_id(), d.nid1, d.nid2, d.pss_position, d.pss_correlation, d.sss_correlation);
+    }
+  }
+}
@@ -0,0 +1,140 @@
+#include "cell_manager.h"
+#include "config.h"
+#include "phy_params_common.h"
+#include "utils.h"
+#include <algorithm>
+#include <spdlog/spdlog.h>
+
+extern struct config config;
+
+namespace nr {
+  /**
+   * Constructor for cell_manager.
+   *
+   * The cell search uses the same resampling filter as the syncer.
+   */
+  cell_manager::cell_manager(uint64_t sample_rate, uint16_t ssb_numerology, const std::string& zmq_address) :
+    sample_rate(sample_rate),
+    ssb_numerology(ssb_numerology),
+    ssb_bwp(make_shared<bandwidth_part>(3'840'000 * (1<<ssb_numerology), ssb_numerology, ssb_rb)),
+    // Create pool of 64 flows that can process samples in parallel after synchronization, shared by all cells
+    pool(make_shared<flow_pool>(64, zmq_address)),
+    downsampler(sample_rate, ssb_bwp->sample_rate, 51, 0.08f, 70.0f, 16),
+    detector(config.cell_search_threshold, config.max_cells, ssb_bwp->samples_per_cp(4)),
+    searching(false),
+    search_start(0),
+    next_search(0),
+    total_samples(0) {
+  }
+
+  /**
+   * Destructor for cell_manager.
+   */
+  cell_manager::~cell_manager() {
+  }
+
+  /**
+   * Passes the samples to the syncer of every cell, drops the cells that lost
+   * synchronization for too long, and searches for new cells when a search is
+   * due.
+   */
+  void cell_manager::process(shared_ptr<vector<complex<float>>>& samples, int64_t metadata) {
+    // The syncers apply their CFO into buffers of their own, so they can share the chunk
+    send_to_next_workers(samples, metadata);
+    retire_cells(samples->size());
+
+    if (!searching && total_samples >= next_search) {
+      searching = true;
+      search_start = total_samples;
+      downsampler.reset();
+    }
+    if (searching) {
+      auto search_t0 = time_profile_start();
+      search(*samples);
+      time_profile_end(search_t0, "cell_manager::search");
+    }
+
+    total_samples += samples->size();
+  }
+
+  /**
+   * Downsamples the samples into the search in progress, and detects the
+   * cells in it once it spans an SSB period and an SSB.
+   */
+  void cell_manager::search(const vector<complex<float>>& samples) {
+    downsampler.execute(samples, search_samples);
+
+    float ssb_period = 0.02; // As assumed by the syncer
+    size_t ssb_num_samples = 6 * ssb_bwp->samples_per_symbol(1);
+    if (search_samples.size() < ssb_bwp->sample_rate * ssb_period + ssb_num_samples) {
+      return;
+    }
+
+    vector<cell_detector::detection> detections;
+    detector.detect(detections, search_samples);
+    SPDLOG_DEBUG("[CELLS] Search found {} cells, following {}", detections.size(), cells.size());
+    for (const auto& detection : detections) {
+      if (cells.size() >= config.max_cells) {
+        break;
+      }
+      bool known = std::any_of(cells.begin(), cells.end(), [&detection](const cell& c) {
+        return c.cell_id == detection.get_cell_id();
+      });
+      if (!known) {
+        add_cell(detection, samples.size());
+      }
+    }
+
+    search_samples.clear();
+    searching = false;
+    next_search = search_start + static_cast<uint64_t>(sample_rate * (config.cell_search_period_ms / 1000.0));
+  }
+
+  /**
+   * Creates the syncer of a detected cell. It receives samples from the next
+   * chunk on, and first looks for the PSS around the SSB following the
+   * detected one.
+   *
+   * @param num_samples size of the current chunk
+   */
+  void cell_manager::add_cell(const cell_detector::detection& detection, size_t num_samples) {
+    auto phy = make_shared<nr::phy>();
+    phy->ssb_bwp = make_unique<bandwidth_part>(3'840'000 * (1<<ssb_numerology), ssb_numerology, ssb_rb);
+    auto cell_syncer = make_shared<syncer>(sample_rate, phy, pool, detection.nid2, true);
+
+    // Full-rate position of the PSS, accounting for the delay of the resampling filter, and of its slot
+    double rate = (double)ssb_bwp->sample_rate / (double)sample_rate;
+    double pss_position = search_start + detection.pss_position / rate - downsampler.get_delay();
+    double pss_offset = (ssb_bwp->samples_per_symbol(0) + ssb_bwp->samples_per_symbol(1) + ssb_bwp->samples_per_cp(2)) / rate;
+    int64_t slot_start = std::llround(pss_position - pss_offset) - static_cast<int64_t>(total_samples);
+
+    // The syncer expects the SSB at most an SSB period after the last one
+    int64_t ssb_period_samples = sample_rate * 0.02;
+    while (static_cast<int64_t>(num_samples) - slot_start > ssb_period_samples) {
+      slot_start += ssb_period_samples;
+    }
+    cell_syncer->expect_cell(detection.nid1, slot_start, num_samples);
+
+    this->connect(cell_syncer);
+    cells.push_back({detection.get_cell_id(), phy, cell_syncer, 0});
+    SPDLOG_INFO("[CELLS] Following cell ID {} (PSS corr {:.2f}, SSS corr {:.2f}), {} cells", detection.get_cell_id(), detection.pss_correlation, detection.sss_correlation, cells.size());
+  }
+
+  /**
+   * Drops the cells that were not synchronized for cell_timeout_ms. Their
+   * flows are released back to the pool with their syncer.
+   */
+  void cell_manager::retire_cells(size_t num_samples) {
+    uint64_t timeout_samples = sample_rate * (config.cell_timeout_ms / 1000.0);
+    for (auto it = cells.begin(); it != cells.end();) {
+      it->unsynchronized_samples = it->cell_syncer->is_synchronized() ? 0 : it->unsynchronized_samples + num_samples;
+      if (it->unsynchronized_samples > timeout_samples) {
+        SPDLOG_INFO("[CELLS] Lost cell ID {}, {} cells", it->cell_id, cells.size() - 1);
+        this->disconnect(it->cell_syncer);
+        it = cells.erase(it);
+      } else {
+        ++it;
+      }
+    }
+  }
+}
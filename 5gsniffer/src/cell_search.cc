@@ -1,45 +1,87 @@
-// #include <iostream>
-// #include <cstdlib>
-// #include <unistd.h>
-// #include "args_manager.h"
-
-// // #ifdef __cplusplus
-// // extern "C" {
-// // #undef I // Fix complex.h #define I nastiness when using C++
-// #include "srsran/srsran.h"
-// #include "srsran/phy/rf/rf_utils.h"
-// #include "srsran/phy/rf/rf.h"
-// // }
-
-// using namespace std;
-
-// char rf_dev[]  = "";
-// char rf_args[]  = "";
-
-// int main(int argc, char** argv) {
-
-//   args_t args;
-//   args_manager::parse_args(args, argc, argv);
-
-//   int                           n;
-//   srsran_rf_t                   rf;
-//   srsran_ue_cellsearch_t        cs;
-//   srsran_ue_cellsearch_result_t found_cells[3];
-//   int                           nof_freqs;
-//   // srsran_earfcn_t               channels[MAX_EARFCN];
-//   uint32_t                      freq;
-//   uint32_t                      n_found_cells = 0;
-
-//   printf("Opening RF device...\n");
-
-//   if (srsran_rf_open_devname(&rf, rf_dev, rf_args, 1)) {
-//     // ERROR("Error opening rf");
-//     cout << "error opening rf" << endl;
-//     exit(-1);
-//   }
-//   cout << "opened" << endl;
-
-//   // DEBUG(" ----  Receive %d samples  ---- ", nsamples);
-//   // return srsran_rf_recv_with_time((srsran_rf_t*)h, data, nsamples, 1, NULL, NULL);
-//   srsran_rf_close(&rf);
-// }
+#include <cstdint>
+#include <cstdio>
+#include <iostream>
+#include <memory>
+
+#include "spdlog/spdlog.h"
+#include "spdlog/cfg/env.h"
+#include "args_manager.h"
+#include "exceptions.h"
+#include "fft_plan.h"
+#include "file_source.h"
+#include "gscn_scanner.h"
+#include "phy_params_common.h"
+#include "sdr.h"
+#include "zmq_source.h"
+
+using namespace std;
+
+/**
+ * Cell search over every GSCN raster position of a wideband capture, from an
+ * SDR, a file or a ZMQ IQ stream centered at the given frequency. Prints the
+ * cells found with their frequency, SNR and MIB.
+ *
+ * @param argc
+ * @param argv
+ */
+int main(int argc, char** argv) {
+  // Load spdlog level from environment variable
+  // For example: export SPDLOG_LEVEL=debug
+  spdlog::cfg::load_env_levels();
+
+  // Set logger pattern
+  spdlog::set_pattern("[%^%l%$] [%H:%M:%S.%f thread %t] [%s:%#] %v");
+
+  args_t args;
+  args_manager::parse_args(args, argc, argv);
+
+  if (!args.fft_wisdom_path.empty()) {
+    nr::fft_plan::load_wisdom(args.fft_wisdom_path);
+  }
+
+  try {
+    unique_ptr<worker> device;
+    if (args.input_file_name != "") {
+      device = make_unique<file_source>(args.sample_rate, args.input_file_name);
+    } else if (args.zmq_address != "") {
+      device = make_unique<zmq_source>(args.zmq_address);
+    } else {
+      double rx_gain = args.rf_gain < 0 ? 40.0 : args.rf_gain;
+      device = make_unique<sdr>(args.sample_rate, args.rf_freq, args.rf_args, rx_gain);
+    }
+    bool ended = false;
+    device->on_end = [&ended]() { ended = true; };
+
+    nr::gscn_scanner scanner(args.sample_rate, args.rf_freq, args.ssb_numerology, args.threshold, args.num_threads);
+
+    // Capture a block of samples long enough to see an SSB of every cell
+    vector<complex<float>> samples;
+    size_t num_samples = scanner.get_num_samples();
+    samples.reserve(num_samples);
+    while (samples.size() < num_samples && !ended) {
+      auto chunk = device->produce_samples(num_samples - samples.size());
+      samples.insert(samples.end(), chunk->begin(), chunk->end());
+    }
+    if (samples.size() < num_samples) {
+      SPDLOG_WARN("Only {} of {} samples available, some cells may be missed", samples.size(), num_samples);
+    }
+
+    uint8_t nid_2 = args.force_N_id_2 >= 0 ? args.force_N_id_2 : nid_2_max + 1;
+    auto results = scanner.scan(samples, nid_2);
+
+    printf("%-8s %-16s %-8s %-10s %-10s %s\n", "GSCN", "Frequency (MHz)", "PCI", "SNR (dB)", "CFO (Hz)", "MIB");
+    for (auto& r : results) {
+      char mib_str[512] = "not decoded";
+      if (r.mib_found) {
+        srsran_pbch_msg_nr_mib_info(&r.mib, mib_str, sizeof(mib_str));
+      }
+      printf("%-8u %-16.3f %-8u %-10.1f %-10.0f %s\n", r.gscn, r.frequency / 1e6, r.cell_id, r.snr_db, r.cfo, mib_str);
+    }
+    printf("%zu cells found on %zu raster positions\n", results.size(), scanner.get_channels().size());
+  } catch (sniffer_exception& e) {
+    SPDLOG_ERROR(e.what());
+    return 1;
+  }
+
+  return 0;
+}
@@ -31,6 +31,23 @@ channel_mapper::channel_mapper(shared_ptr<nr::phy> phy, pdcch_config pdcch_confi
   pdcch.sc_power_decision = pdcch_config.sc_power_decision;
   pdcch.sample_rate_time = pdcch_config.sample_rate_time;
   pdcch.rnti_list_length = pdcch_config.rnti_list_length;
+  pdcch.rnti_aging_ms = pdcch_config.rnti_aging_ms;
+  pdcch.slot_budget_us = pdcch_config.slot_budget_us;
+  nr::lag_controller::instance().configure(pdcch_config.max_lag_ms);
+  pdcch.rnti_recovery = pdcch_config.rnti_recovery;
+  pdcch.rnti_recovery_min_hits = pdcch_config.rnti_recovery_min_hits;
+  pdcch.rnti_recovery_window_ms = pdcch_config.rnti_recovery_window_ms;
+  pdcch.use_scrambling_id_solver = pdcch_config.scrambling_id_solver;
+  pdcch.dmrs_cache_size_mb = pdcch_config.dmrs_cache_size_mb;
+  pdcch.dmrs_prefetch = pdcch_config.dmrs_prefetch;
+  pdcch.hierarchical_search = pdcch_config.hierarchical_search;
+  pdcch.hierarchical_energy_ratio = pdcch_config.hierarchical_energy_ratio;
+  pdcch.discovery_ms = pdcch_config.discovery_ms;
+  pdcch.rescan_period_ms = pdcch_config.rescan_period_ms;
+  pdcch.rescan_ms = pdcch_config.rescan_ms;
+  if (pdcch_config.threads > 0) {
+    pdcch.task_executor = nr::executor::shared(pdcch_config.threads);
+  }
   std::vector<uint8_t> num_candidates_per_AL = pdcch_config.num_candidates_per_AL;  
 
   coreset coreset_info_(pdcch_config.coreset_id,
@@ -59,6 +76,16 @@ channel_mapper::~channel_mapper() {
 
 }
 
+vector<uint8_t> channel_mapper::get_symbol_indices() {
+  uint8_t coreset_duration = pdcch.get_coreset_info().get_duration();
+  uint8_t coreset_ofdm_symbol_start = pdcch.get_coreset_info().get_starting_ofdm_symbol_within_slot();
+  vector<uint8_t> symbol_indices;
+  for (uint8_t l = coreset_ofdm_symbol_start; l < coreset_ofdm_symbol_start + coreset_duration; l++) {
+    symbol_indices.push_back(l);
+  }
+  return symbol_indices;
+}
+
 void channel_mapper::process(shared_ptr<vector<symbol>>& symbols, int64_t metadata) {
   SPDLOG_DEBUG("Got {} symbols", symbols->size());
 
@@ -83,4 +110,25 @@ void channel_mapper::process(shared_ptr<vector<symbol>>& symbols, int64_t metada
   }
 
   pdcch.process(to_process, metadata);
-}
\ No newline at end of file
+}
+
+/** 
+ * Same as processing the symbols of the grid, but only the CORESET symbols
+ * are copied, each CORESET at once since its symbols are consecutive rows.
+ */
+void channel_mapper::process(const shared_ptr<slot_grid>& grid, int64_t metadata) {
+  SPDLOG_DEBUG("Got {} symbols", grid->size());
+
+  uint8_t coreset_duration = pdcch.get_coreset_info().get_duration();
+  uint8_t coreset_ofdm_symbol_start = pdcch.get_coreset_info().get_starting_ofdm_symbol_within_slot();
+
+  auto to_process = make_shared<vector<symbol>>();
+  for (size_t idx = 0; idx + coreset_duration <= grid->size(); idx++) {
+    if (grid->symbols[idx].symbol_index == coreset_ofdm_symbol_start) {
+      to_process->push_back(grid->to_symbol(idx, coreset_duration));
+      idx = idx + coreset_duration - 1;
+    }
+  }
+
+  pdcch.process(to_process, metadata);
+}
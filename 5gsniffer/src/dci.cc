@@ -106,11 +106,11 @@ bool dci::get_found_possible_dci(){
   return found_possible_dci;
 }
 
-uint8_t dci::get_found_aggregation_level(){
+uint8_t dci::get_found_aggregation_level() const {
   return found_aggregation_level;
 }
 
-uint8_t dci::get_found_candidate(){ 
+uint8_t dci::get_found_candidate() const {
   return found_candidate;
 }
 
@@ -146,11 +146,11 @@ uint16_t dci::get_nof_bits(){
   return nof_bits;
 }
 
-uint16_t dci::get_pdcch_scrambling_id(){
+uint16_t dci::get_pdcch_scrambling_id() const {
   return pdcch_scrambling_id;
 }
 
-uint8_t dci::get_n_slot(){
+uint8_t dci::get_n_slot() const {
   return n_slot;
 }
 
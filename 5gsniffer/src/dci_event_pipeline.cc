@@ -0,0 +1,185 @@
+#include "dci_event_pipeline.h"
+#include "config.h"
+#include "rnti_tracker.hpp"
+#include <chrono>
+#include <spdlog/spdlog.h>
+#include <srsran/srsran.h>
+
+namespace nr {
+  // Time the consumer sleeps when every ring is empty
+  static constexpr auto idle_wait = std::chrono::microseconds(500);
+  // Minimum time between two logs of dropped records
+  static constexpr auto drop_report_period = std::chrono::seconds(1);
+
+  void dci_record::pack_payload(const uint8_t* bits, uint8_t nof_bits_) {
+    nof_bits = nof_bits_;
+    payload.fill(0);
+    for (size_t i = 0; i < nof_bits; i++) {
+      payload[i / 8] |= (bits[i] & 1) << (7 - i % 8);
+    }
+  }
+
+  void dci_record::unpack_payload(uint8_t* bits) const {
+    for (size_t i = 0; i < nof_bits; i++) {
+      bits[i] = (payload[i / 8] >> (7 - i % 8)) & 1;
+    }
+  }
+
+  dci_event_pipeline::dci_event_pipeline() : handle(&dci_event_pipeline::report) {
+  }
+
+  dci_event_pipeline::~dci_event_pipeline() {
+    stop();
+  }
+
+  dci_event_pipeline& dci_event_pipeline::instance() {
+    static dci_event_pipeline inst;
+    return inst;
+  }
+
+  void dci_event_pipeline::start() {
+    if (running.exchange(true)) {
+      return;
+    }
+    consumer = std::thread(&dci_event_pipeline::consumer_loop, this);
+    SPDLOG_DEBUG("Started DCI event consumer");
+  }
+
+  void dci_event_pipeline::stop() {
+    if (!running.exchange(false)) {
+      return;
+    }
+    // Publishers that saw the pipeline running may still be pushing
+    while (publishers.load() > 0) {
+      std::this_thread::yield();
+    }
+    consumer.join();
+    // Records published while the consumer was exiting
+    drain();
+  }
+
+  bool dci_event_pipeline::publish(const dci_record& record) {
+    // Counted before checking running, so stop() either sees this publisher
+    // or this publisher sees the pipeline stopped
+    publishers.fetch_add(1);
+    if (!running.load()) {
+      publishers.fetch_sub(1);
+      static std::mutex inline_mutex;
+      std::lock_guard<std::mutex> lock(inline_mutex);
+      handle(record);
+      return true;
+    }
+    bool pushed = thread_ring()->push(record);
+    publishers.fetch_sub(1, std::memory_order_release);
+    return pushed;
+  }
+
+  void dci_event_pipeline::set_handler(handler handler_) {
+    if (running) {
+      SPDLOG_ERROR("Cannot replace the handler of a running DCI event pipeline");
+      return;
+    }
+    handle = std::move(handler_);
+  }
+
+  uint64_t dci_event_pipeline::get_dropped() {
+    std::lock_guard<std::mutex> lock(rings_mutex);
+    uint64_t dropped = 0;
+    for (auto& r : rings) {
+      dropped += r->get_dropped();
+    }
+    return dropped;
+  }
+
+  /**
+  * Returns the ring of the calling thread, registering one on its first
+  * publish. Rings live as long as the pipeline.
+  */
+  dci_event_pipeline::ring* dci_event_pipeline::thread_ring() {
+    static thread_local ring* local_ring = nullptr;
+    if (local_ring == nullptr) {
+      std::lock_guard<std::mutex> lock(rings_mutex);
+      rings.push_back(std::make_unique<ring>());
+      local_ring = rings.back().get();
+    }
+    return local_ring;
+  }
+
+  /**
+  * Handles every queued record, ring by ring so the records of each thread
+  * keep their order.
+  *
+  * @return true if any record was handled
+  */
+  bool dci_event_pipeline::drain() {
+    std::vector<ring*> snapshot;
+    {
+      std::lock_guard<std::mutex> lock(rings_mutex);
+      snapshot.reserve(rings.size());
+      for (auto& r : rings) {
+        snapshot.push_back(r.get());
+      }
+    }
+
+    bool handled = false;
+    dci_record record;
+    for (ring* r : snapshot) {
+      while (r->pop(record)) {
+        handle(record);
+        handled = true;
+      }
+    }
+    return handled;
+  }
+
+  void dci_event_pipeline::consumer_loop() {
+    auto last_report = std::chrono::steady_clock::now();
+    while (running.load(std::memory_order_acquire)) {
+      if (!drain()) {
+        std::this_thread::sleep_for(idle_wait);
+      }
+
+      auto now = std::chrono::steady_clock::now();
+      if (now - last_report >= drop_report_period) {
+        last_report = now;
+        uint64_t dropped = get_dropped();
+        if (dropped > reported_dropped) {
+          SPDLOG_WARN("[DCI_EVENTS] dropped_records={} total_dropped={}", dropped - reported_dropped, dropped);
+          reported_dropped = dropped;
+        }
+      }
+    }
+    drain();
+  }
+
+  void dci_event_pipeline::report(const dci_record& record) {
+    uint8_t bits[dci_record::max_payload_bits];
+    record.unpack_payload(bits);
+    srsran_vec_fprint_hex(stdout, bits, record.nof_bits);
+    char dci_msg_bin[dci_record::max_payload_bits + 1];
+    srsran_vec_sprint_bin(dci_msg_bin, record.nof_bits + 1, bits, record.nof_bits);
+
+    float sample_time = ((float) record.sample_index) / record.sample_rate;
+    SPDLOG_INFO("Found DCI PDCCH DCI: RNTI = {}, AL = {}, DCI size {}, Time = {}, Samples from start = {}, Slots from samples from start = {} Slot within frame = {}, Symbol within slot = {}, binary dci is {}, correlation is {}",
+    record.rnti, record.aggregation_level, record.nof_bits, sample_time + record.symbol_in_chunk * 0.001, sample_time, record.symbol_in_chunk, record.slot, record.ofdm_symbol, dci_msg_bin, record.correlation);
+
+    // MHZ - Track RNTI decoded over time, saving details
+    if (config.rnti_tracker.enabled) {
+      RntiEvent ev{};
+      ev.rnti = record.rnti;
+      ev.cell_id = record.cell_id;
+      ev.scrambling_id = record.scrambling_id;
+      ev.coreset_id = record.coreset_id;
+      ev.aggregation_level = record.aggregation_level;
+      ev.candidate_idx = record.candidate_idx;
+      ev.slot = record.slot;
+      ev.ofdm_symbol = record.ofdm_symbol;
+      ev.num_symbols_per_slot = 0; // dci_.get_num_symbols_per_slot(ev.slot); // TO FIX
+      ev.correlation = record.correlation;
+      ev.sample_index = record.sample_index;
+      ev.t_seconds = static_cast<double>(record.sample_index) / static_cast<double>(record.sample_rate);
+
+      RntiTracker::instance().observe(ev);
+    }
+  }
+}
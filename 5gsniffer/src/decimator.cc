@@ -0,0 +1,86 @@
+#include "decimator.h"
+#include "spdlog/spdlog.h"
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <volk/volk.h>
+
+using namespace std;
+
+/** 
+ * Constructor for decimator.
+ */
+decimator::decimator(uint64_t input_rate, uint64_t output_rate, unsigned int h_len, float bw, float slsl, unsigned int npfb) :
+  rate((float)output_rate / (float)input_rate),
+  factor(0),
+  delay(h_len),
+  skip(0),
+  resampler(nullptr) {
+  if (output_rate > 0 && output_rate <= input_rate && input_rate % output_rate == 0) {
+    factor = input_rate / output_rate;
+
+    // Same lowpass as the arbitrary-rate resampler, normalized to unity DC gain
+    taps.resize(2 * h_len + 1);
+    liquid_firdes_kaiser(taps.size(), bw, slsl, 0.0f, taps.data());
+    float gain = std::accumulate(taps.begin(), taps.end(), 0.0f);
+    for (float& tap : taps) {
+      tap /= gain;
+    }
+    std::reverse(taps.begin(), taps.end());
+    buffer.assign(taps.size() - 1, 0);
+    SPDLOG_DEBUG("Decimating by {} with a {}-tap FIR", factor, taps.size());
+  } else {
+    resampler = resamp_crcf_create(rate, h_len, bw, slsl, npfb);
+    SPDLOG_DEBUG("Resampling at a rate of {}", rate);
+  }
+}
+
+/** 
+ * Destructor for decimator.
+ */
+decimator::~decimator() {
+  if (resampler != nullptr) {
+    resamp_crcf_destroy(resampler);
+  }
+}
+
+void decimator::execute(span<const complex<float>> input, vector<complex<float>>& output) {
+  if (input.empty()) {
+    return;
+  }
+
+  if (!is_integer()) {
+    size_t start = output.size();
+    output.resize(start + (size_t)ceilf(input.size() * rate) + 2);
+    unsigned int num_written = 0;
+    resamp_crcf_execute_block(resampler, const_cast<complex<float>*>(input.data()), input.size(), output.data() + start, &num_written);
+    output.resize(start + num_written);
+    return;
+  }
+
+  // The block follows the history, so the window of every output lies in the buffer
+  size_t history = taps.size() - 1;
+  buffer.resize(history);
+  buffer.insert(buffer.end(), input.begin(), input.end());
+
+  size_t num_outputs = skip < input.size() ? (input.size() - skip + factor - 1) / factor : 0;
+  size_t start = output.size();
+  output.resize(start + num_outputs);
+  complex<float>* out = output.data() + start;
+  for (size_t i = 0; i < num_outputs; i++) {
+    // Window ends at input sample skip + i * factor
+    volk_32fc_32f_dot_prod_32fc(out + i, buffer.data() + skip + i * factor, taps.data(), taps.size());
+  }
+  skip = skip + num_outputs * factor - input.size();
+
+  buffer.erase(buffer.begin(), buffer.end() - history);
+}
+
+void decimator::reset() {
+  skip = 0;
+  if (is_integer()) {
+    buffer.assign(taps.size() - 1, 0);
+  } else {
+    resamp_crcf_reset(resampler);
+  }
+}
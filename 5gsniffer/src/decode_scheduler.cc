@@ -0,0 +1,105 @@
+#include "decode_scheduler.h"
+#include <algorithm>
+#include <spdlog/spdlog.h>
+
+namespace nr {
+  // Minimum time between two coverage changes, so the lag can react to the previous one
+  static constexpr auto level_hold_time = std::chrono::milliseconds(100);
+  // Fewest RNTIs tried per candidate at any level
+  static constexpr int min_rnti_list_length = 16;
+
+  decode_deadline::decode_deadline(uint32_t budget_us) :
+    unlimited(budget_us == 0),
+    end(std::chrono::steady_clock::now() + std::chrono::microseconds(budget_us)) {
+  }
+
+  bool decode_deadline::expired() const {
+    return !unlimited && std::chrono::steady_clock::now() >= end;
+  }
+
+  lag_controller& lag_controller::instance() {
+    static lag_controller inst;
+    return inst;
+  }
+
+  void lag_controller::configure(uint32_t max_lag_ms_) {
+    std::lock_guard<std::mutex> lock(mutex);
+    max_lag_ms = max_lag_ms_;
+  }
+
+  void lag_controller::update(double sample_time_s) {
+    update(sample_time_s, std::chrono::steady_clock::now());
+  }
+
+  void lag_controller::update(double sample_time_s, std::chrono::steady_clock::time_point now) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (max_lag_ms == 0) {
+      return;
+    }
+
+    if (!started) {
+      started = true;
+      first_sample_time_s = sample_time_s;
+      first_wall_time = now;
+      last_change = now;
+      last_report = now;
+      return;
+    }
+
+    double wall_elapsed_ms = std::chrono::duration<double, std::milli>(now - first_wall_time).count();
+    lag_ms = wall_elapsed_ms - (sample_time_s - first_sample_time_s) * 1000.0;
+    if (now - last_change < level_hold_time) {
+      return;
+    }
+
+    if (lag_ms > max_lag_ms && level < max_level) {
+      level++;
+      last_change = now;
+      SPDLOG_WARN("Decoding lags {:.1f} ms behind the samples, reducing coverage to level {}", lag_ms, level.load());
+    } else if (lag_ms < max_lag_ms / 2.0 && level > 0) {
+      level--;
+      last_change = now;
+      SPDLOG_INFO("Decoding lag down to {:.1f} ms, restoring coverage to level {}", lag_ms, level.load());
+    }
+  }
+
+  int lag_controller::rnti_list_length(int configured) const {
+    return std::min(configured, std::max(configured >> level, min_rnti_list_length));
+  }
+
+  int lag_controller::min_agg_level() const {
+    return std::max(level - 2, 0);
+  }
+
+  void lag_controller::report() {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto now = std::chrono::steady_clock::now();
+    if (now - last_report < std::chrono::seconds(1)) {
+      return;
+    }
+    last_report = now;
+
+    uint64_t shed = shed_candidates.exchange(0);
+    uint64_t truncated = truncated_candidates.exchange(0);
+    if (shed > 0 || truncated > 0 || level > 0) {
+      SPDLOG_INFO("[DECODE_SHED] lag_ms={:.1f} level={} shed_candidates={} truncated_candidates={}", lag_ms, level.load(), shed, truncated);
+    }
+  }
+
+  lag_controller::state lag_controller::save() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return {max_lag_ms, started, first_sample_time_s, first_wall_time, last_change, last_report, lag_ms, level};
+  }
+
+  void lag_controller::restore(const state& saved) {
+    std::lock_guard<std::mutex> lock(mutex);
+    max_lag_ms = saved.max_lag_ms;
+    started = saved.started;
+    first_sample_time_s = saved.first_sample_time_s;
+    first_wall_time = saved.first_wall_time;
+    last_change = saved.last_change;
+    last_report = saved.last_report;
+    lag_ms = saved.lag_ms;
+    level = saved.level;
+  }
+}
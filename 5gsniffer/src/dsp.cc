@@ -1,11 +1,13 @@
 #include "dsp.h"
 #include "bandwidth_part.h"
+#include "fft_plan.h"
 #include <cmath>
 #include <complex>
 #include <cstdint>
 #include <spdlog/spdlog.h>
 #include <volk/volk.h>
 #include <algorithm>
+#include <bit>
 
 void correlate(vector<complex<float>>& output, span<complex<float>> a, span<complex<float>> b) {
   if (a.size() >= b.size()) {
@@ -36,53 +38,181 @@ void correlate(vector<complex<float>>& output, span<complex<float>> a, span<comp
 }
 
 
-float frobenius_norm(span<complex<float>> input) {
-  vector<float> magsq(input.size());
-  float mag_sum = 0.0f;
-  volk_32fc_magnitude_squared_32f(magsq.data(), input.data(), input.size());
-  volk_32f_accumulator_s32f(&mag_sum, magsq.data(), magsq.size());
-  return std::sqrt(mag_sum);
+float frobenius_norm(span<const complex<float>> input) {
+  // The conjugate dot product of a vector with itself is its energy, without a scratch buffer
+  complex<float> energy = 0;
+  volk_32fc_x2_conjugate_dot_prod_32fc(&energy, input.data(), input.data(), input.size());
+  return std::sqrt(std::max(energy.real(), 0.0f));
+}
+
+/**
+ * Norm of every window of window_size consecutive samples of a. The energy of
+ * each window is a running sum of |a|^2, updated in O(1) per window instead of
+ * recomputed over the whole window.
+ */
+void sliding_window_norms(vector<float>& output, span<const complex<float>> a, size_t window_size) {
+  if (window_size == 0 || a.size() < window_size) {
+    SPDLOG_ERROR("Invalid sizes for sliding window norms: window must fit in the input");
+    output.clear();
+    return;
+  }
+
+  static thread_local vector<float> energies;
+  energies.resize(a.size());
+  volk_32fc_magnitude_squared_32f(energies.data(), a.data(), a.size());
+
+  size_t iterations = a.size() - window_size + 1;
+  output.resize(iterations);
+  // Accumulated in double so the running sum does not drift over long inputs
+  double window_energy = 0;
+  for (size_t i = 0; i < window_size; i++) {
+    window_energy += energies[i];
+  }
+  output[0] = std::sqrt(std::max(window_energy, 0.0));
+  for (size_t i = 1; i < iterations; i++) {
+    window_energy += static_cast<double>(energies[i + window_size - 1]) - energies[i - 1];
+    output[i] = std::sqrt(std::max(window_energy, 0.0));
+  }
+}
+
+/**
+ * Norm of consecutive segments of a, laid out back to back with the start of
+ * each segment (plus the end) in offsets. |a|^2 is computed in a single pass.
+ */
+void segment_norms(vector<float>& output, span<const complex<float>> a, span<const uint32_t> offsets) {
+  if (offsets.empty() || a.size() < offsets.back()) {
+    SPDLOG_ERROR("Invalid sizes for segment norms");
+    output.clear();
+    return;
+  }
+
+  static thread_local vector<float> energies;
+  energies.resize(offsets.back());
+  volk_32fc_magnitude_squared_32f(energies.data(), a.data(), offsets.back());
+
+  output.resize(offsets.size() - 1);
+  for (size_t i = 0; i + 1 < offsets.size(); i++) {
+    float energy = 0;
+    volk_32f_accumulator_s32f(&energy, energies.data() + offsets[i], offsets[i+1] - offsets[i]);
+    output[i] = std::sqrt(energy);
+  }
 }
 
 void correlate_magnitude_normalized(vector<float>& output, span<complex<float>> a, span<complex<float>> b) {
   if (a.size() >= b.size()) {
-    int64_t iterations = a.size() - b.size() + 1;
-    output.resize(iterations);
+    // The window norms are written to output, then replaced by the correlations
+    sliding_window_norms(output, a, b.size());
 
     float b_norm = frobenius_norm(b);
-    for (size_t i = 0; i < iterations; ++i) {
+    for (size_t i = 0; i < output.size(); ++i) {
       complex<float> dot_product = 0;
       volk_32fc_x2_conjugate_dot_prod_32fc(&dot_product, a.data()+i, b.data(), b.size());
 
-      float a_norm = frobenius_norm({a.data()+i, b.size()});
-      output.at(i) = std::abs(dot_product) / (a_norm * b_norm);
+      float norm = output[i] * b_norm;
+      output[i] = norm > 0 ? std::abs(dot_product) / norm : 0;
     }
   } else {
     SPDLOG_ERROR("Invalid sizes for correlation: size of a must be >= b");
   }
 }
 
-void moving_correlate(vector<complex<float>>& output, span<complex<float>> a, span<complex<float>> b, size_t window_size) {
-  if (a.size() == b.size() && window_size <= a.size()) {
-    size_t iterations = a.size();
-    output.resize(iterations);
+/**
+ * Normalized correlation magnitude of a against every row of a real matrix,
+ * whose rows have a.size() values and the given norms. This is one
+ * matrix-vector product: a complex-by-real dot product per row, with the
+ * norm of a computed once.
+ */
+void correlate_magnitude_normalized_rows(vector<float>& output, span<const complex<float>> a, span<const float> matrix, span<const float> row_norms) {
+  size_t rows = row_norms.size();
+  if (rows * a.size() > matrix.size()) {
+    SPDLOG_ERROR("Invalid sizes for matrix correlation: matrix too small");
+    output.clear();
+    return;
+  }
+
+  output.resize(rows);
+  float a_norm = frobenius_norm(a);
+  for (size_t i = 0; i < rows; ++i) {
+    complex<float> dot_product = 0;
+    volk_32fc_32f_dot_prod_32fc(&dot_product, a.data(), matrix.data() + i * a.size(), a.size());
 
-    if (window_size > INT_MAX) {
-      SPDLOG_ERROR("Invalid window size");
-      return;
+    float norm = a_norm * row_norms[i];
+    output[i] = norm > 0 ? std::abs(dot_product) / norm : 0;
+  }
+}
+
+/**
+ * Normalized correlation magnitude of consecutive segments of a and b, laid
+ * out back to back with the start of each segment (plus the end) in offsets.
+ * The norms of every segment are given, so a batch of correlations against
+ * the same a only walks both slabs once.
+ */
+void correlate_segments_normalized(vector<float>& output, span<const complex<float>> a, span<const complex<float>> b, span<const uint32_t> offsets, span<const float> a_norms, span<const float> b_norms) {
+  if (offsets.empty() || a.size() < offsets.back() || b.size() < offsets.back() || a_norms.size() + 1 < offsets.size() || b_norms.size() + 1 < offsets.size()) {
+    SPDLOG_ERROR("Invalid sizes for segmented correlation");
+    return;
+  }
+
+  size_t num_segments = offsets.size() - 1;
+  output.resize(num_segments);
+  for (size_t i = 0; i < num_segments; ++i) {
+    float norm = a_norms[i] * b_norms[i];
+    if (norm <= 0) {
+      output[i] = 0;
+      continue;
     }
+    complex<float> dot_product = 0;
+    volk_32fc_x2_conjugate_dot_prod_32fc(&dot_product, a.data() + offsets[i], b.data() + offsets[i], offsets[i+1] - offsets[i]);
+    output[i] = std::abs(dot_product) / norm;
+  }
+}
 
-    int32_t window_size_int = static_cast<int32_t>(window_size);
-    for(int32_t i = 0; i < iterations; i++) {
-      int32_t start = std::max(i+1 - window_size_int, 0);
-      int32_t length = std::min(i+1, window_size_int);
-      volk_32fc_x2_conjugate_dot_prod_32fc(output.data()+i, a.data()+start, b.data()+start, length);
+/**
+ * Sum of each window of window_size products ending at every index, updated
+ * recursively. The first windows are shorter, covering the available
+ * products. The running sum is kept in double so it does not drift.
+ */
+static void running_window_sum(vector<complex<float>>& output, span<const complex<float>> products, size_t window_size) {
+  output.resize(products.size());
+  complex<double> sum = 0;
+  for (size_t i = 0; i < products.size(); i++) {
+    sum += complex<double>(products[i]);
+    if (i >= window_size) {
+      sum -= complex<double>(products[i - window_size]);
     }
+    output[i] = complex<float>(sum);
+  }
+}
+
+void moving_correlate(vector<complex<float>>& output, span<complex<float>> a, span<complex<float>> b, size_t window_size) {
+  if (a.size() == b.size() && window_size <= a.size()) {
+    static thread_local vector<complex<float>> products;
+    products.resize(a.size());
+    volk_32fc_x2_multiply_conjugate_32fc(products.data(), a.data(), b.data(), a.size());
+    running_window_sum(output, products, window_size);
   } else {
     SPDLOG_ERROR("Invalid sizes for correlation: size of a must be == b");
   }
 }
 
+/**
+ * Moving correlation of a with itself delayed by delay samples, as
+ * moving_correlate() against a copy of a preceded by delay zeros, but reading
+ * the delayed samples from a directly.
+ */
+void moving_correlate_delayed(vector<complex<float>>& output, span<const complex<float>> a, size_t delay, size_t window_size) {
+  if (window_size <= a.size()) {
+    static thread_local vector<complex<float>> products;
+    products.assign(a.size(), 0);
+    if (delay < a.size()) {
+      volk_32fc_x2_multiply_conjugate_32fc(products.data() + delay, a.data() + delay, a.data(), a.size() - delay);
+    }
+    running_window_sum(output, products, window_size);
+  } else {
+    SPDLOG_ERROR("Invalid sizes for correlation: window must fit in a");
+  }
+}
+
 void correlate_magnitude(vector<float>& output, span<complex<float>> a, span<complex<float>> b) {
   if (a.size() >= b.size()) {
     int64_t iterations = a.size() - b.size() + 1;
@@ -125,4 +255,69 @@ void rotate(vector<complex<float>>& output, span<complex<float>> input, float fr
   complex<float> complex_phase_rotation_per_t(std::cos(phase_rotation_per_t), std::sin(phase_rotation_per_t));
 
   volk_32fc_s32fc_x2_rotator_32fc(output.data(), input.data(), complex_phase_rotation_per_t, &phase_start, input.size()); 
-}
\ No newline at end of file
+}
+
+/**
+ * Constructor for overlap_save_correlator. The FFT size is the smallest power
+ * of two of at least four times the reference length, so that three quarters
+ * of every block are valid output.
+ */
+overlap_save_correlator::overlap_save_correlator(const vector<vector<complex<float>>>& references) :
+  reference_length(references.empty() ? 1 : std::max<size_t>(references.front().size(), 1)),
+  fft_size(std::bit_ceil(4 * reference_length)),
+  magnitudes(fft_size) {
+  nr::fft_plan& forward_plan = nr::fft_plan::get(fft_size, true);
+  auto block = forward_plan.input();
+  auto block_fft = forward_plan.output();
+
+  // Zero padded reference spectra, kept for every block
+  for (const auto& reference : references) {
+    if (reference.size() != reference_length) {
+      SPDLOG_ERROR("Invalid sizes for correlation: references must have the same length");
+    }
+    std::fill(block.begin(), block.end(), 0);
+    std::copy_n(reference.begin(), std::min(reference.size(), reference_length), block.begin());
+    forward_plan.execute();
+    reference_ffts.emplace_back(block_fft.begin(), block_fft.end());
+  }
+}
+
+void overlap_save_correlator::correlate_magnitude(vector<vector<float>>& outputs, span<const complex<float>> a) {
+  outputs.resize(reference_ffts.size());
+  if (a.size() < reference_length) {
+    SPDLOG_ERROR("Invalid sizes for correlation: size of a must be >= b");
+    for (auto& output : outputs) {
+      output.clear();
+    }
+    return;
+  }
+
+  size_t iterations = a.size() - reference_length + 1;
+  for (auto& output : outputs) {
+    output.resize(iterations);
+  }
+
+  // The first fft_size - M + 1 lags of each circular correlation do not wrap around
+  size_t valid_per_block = fft_size - reference_length + 1;
+  float scale = 1.0f / fft_size;
+  nr::fft_plan& forward_plan = nr::fft_plan::get(fft_size, true);
+  nr::fft_plan& inverse_plan = nr::fft_plan::get(fft_size, false);
+  auto block = forward_plan.input();
+  auto block_fft = forward_plan.output();
+  auto product = inverse_plan.input();
+  auto product_ifft = inverse_plan.output();
+  for (size_t start = 0; start < iterations; start += valid_per_block) {
+    size_t available = std::min(fft_size, a.size() - start);
+    std::copy_n(a.begin() + start, available, block.begin());
+    std::fill(block.begin() + available, block.end(), 0);
+    forward_plan.execute();
+
+    size_t num_valid = std::min(valid_per_block, iterations - start);
+    for (size_t i = 0; i < reference_ffts.size(); i++) {
+      volk_32fc_x2_multiply_conjugate_32fc(product.data(), block_fft.data(), reference_ffts[i].data(), fft_size);
+      inverse_plan.execute();
+      volk_32fc_magnitude_32f(magnitudes.data(), product_ifft.data(), num_valid);
+      volk_32f_s32f_multiply_32f(outputs[i].data() + start, magnitudes.data(), scale, num_valid);
+    }
+  }
+}
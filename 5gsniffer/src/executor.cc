@@ -0,0 +1,188 @@
+#include "executor.h"
+#include <algorithm>
+#include <iterator>
+#include <spdlog/spdlog.h>
+
+namespace nr {
+  // Executor and deque index of the current thread, if it belongs to a pool
+  static thread_local executor* current_executor = nullptr;
+  static thread_local size_t current_queue = 0;
+
+  /**
+  * Constructor for executor.
+  *
+  * @param num_threads number of pool threads
+  */
+  executor::executor(size_t num_threads) {
+    num_threads = std::max<size_t>(num_threads, 1);
+    queues.reserve(num_threads);
+    for (size_t i = 0; i < num_threads; i++) {
+      queues.push_back(std::make_unique<task_queue>());
+    }
+    threads.reserve(num_threads);
+    for (size_t i = 0; i < num_threads; i++) {
+      threads.emplace_back(&executor::worker_loop, this, i);
+    }
+    SPDLOG_DEBUG("Started executor with {} threads", num_threads);
+  }
+
+  /**
+  * Destructor for executor. Pending tasks are dropped.
+  */
+  executor::~executor() {
+    {
+      std::lock_guard<std::mutex> lock(sleep_mutex);
+      stop = true;
+    }
+    sleep_cv.notify_all();
+    for (std::thread& thread : threads) {
+      thread.join();
+    }
+  }
+
+  std::shared_ptr<executor> executor::shared(size_t num_threads) {
+    static std::mutex mutex;
+    static std::shared_ptr<executor> instance;
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!instance) {
+      instance = std::make_shared<executor>(num_threads);
+    }
+    return instance;
+  }
+
+  void executor::submit(std::function<void()> task, const task_group* group) {
+    size_t index = current_executor == this ? current_queue : next_queue++ % queues.size();
+    // Counted before it is queued, so the count never drops below the queued tasks
+    {
+      std::lock_guard<std::mutex> lock(sleep_mutex);
+      pending_tasks++;
+    }
+    {
+      std::lock_guard<std::mutex> lock(queues[index]->mutex);
+      queues[index]->tasks.push_back({group, std::move(task)});
+    }
+    sleep_cv.notify_one();
+  }
+
+  bool executor::pop_task(std::function<void()>& task, const task_group* group) {
+    size_t first = current_executor == this ? current_queue : 0;
+    auto matches = [group](const queued_task& queued) { return group == nullptr || queued.group == group; };
+
+    // Newest task of the own deque first
+    if (current_executor == this) {
+      std::lock_guard<std::mutex> lock(queues[first]->mutex);
+      auto& tasks = queues[first]->tasks;
+      auto it = std::find_if(tasks.rbegin(), tasks.rend(), matches);
+      if (it != tasks.rend()) {
+        task = std::move(it->run);
+        tasks.erase(std::next(it).base());
+        pending_tasks--;
+        return true;
+      }
+    }
+
+    // Otherwise steal the oldest task of another deque
+    for (size_t i = 0; i < queues.size(); i++) {
+      task_queue& queue = *queues[(first + i) % queues.size()];
+      std::lock_guard<std::mutex> lock(queue.mutex);
+      auto it = std::find_if(queue.tasks.begin(), queue.tasks.end(), matches);
+      if (it != queue.tasks.end()) {
+        task = std::move(it->run);
+        queue.tasks.erase(it);
+        pending_tasks--;
+        return true;
+      }
+    }
+    return false;
+  }
+
+  bool executor::run_pending_task(const task_group* group) {
+    std::function<void()> task;
+    if (!pop_task(task, group)) {
+      return false;
+    }
+    task();
+    return true;
+  }
+
+  void executor::worker_loop(size_t index) {
+    current_executor = this;
+    current_queue = index;
+
+    while (true) {
+      if (run_pending_task()) {
+        continue;
+      }
+      std::unique_lock<std::mutex> lock(sleep_mutex);
+      sleep_cv.wait(lock, [this] { return stop || pending_tasks > 0; });
+      if (stop) {
+        return;
+      }
+    }
+  }
+
+  /**
+  * Constructor for task_group.
+  *
+  * @param exec executor to run the tasks on, or nullptr to run them inline
+  */
+  task_group::task_group(executor* exec) :
+    exec(exec) {
+  }
+
+  task_group::~task_group() {
+    // Tasks reference the group, so it must outlive them
+    if (exec != nullptr) {
+      join();
+    }
+  }
+
+  void task_group::run(std::function<void()> task) {
+    if (exec == nullptr) {
+      task();
+      return;
+    }
+
+    outstanding++;
+    exec->submit([this, task = std::move(task)]() {
+      try {
+        task();
+      } catch (...) {
+        std::lock_guard<std::mutex> lock(error_mutex);
+        if (!error) {
+          error = std::current_exception();
+        }
+      }
+      // Under the lock, so the group is not destroyed before the last task is done with it
+      std::lock_guard<std::mutex> lock(done_mutex);
+      if (--outstanding == 0) {
+        done_cv.notify_all();
+      }
+    }, this);
+  }
+
+  /**
+  * Runs the pending tasks of the group on the calling thread, which bounds the
+  * nesting of waits to the nesting of the groups. Once none are left queued,
+  * sleeps until those running on other threads are done.
+  */
+  void task_group::join() {
+    while (exec->run_pending_task(this)) {
+    }
+    std::unique_lock<std::mutex> lock(done_mutex);
+    done_cv.wait(lock, [this] { return outstanding == 0; });
+  }
+
+  void task_group::wait() {
+    if (exec != nullptr) {
+      join();
+    }
+
+    std::lock_guard<std::mutex> lock(error_mutex);
+    if (error) {
+      std::exception_ptr e = error;
+      error = nullptr;
+      std::rethrow_exception(e);
+    }
+  }
+}
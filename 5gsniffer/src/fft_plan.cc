@@ -0,0 +1,113 @@
+#include "fft_plan.h"
+#include <algorithm>
+#include <atomic>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <tuple>
+#include <volk/volk.h>
+#include <spdlog/spdlog.h>
+
+namespace nr {
+  /**
+   * The FFTW planner is not thread-safe, so plans are created and destroyed,
+   * and wisdom loaded and saved, under one lock. Executing plans is safe.
+   */
+  static std::mutex& planner_mutex() {
+    static std::mutex mutex;
+    return mutex;
+  }
+
+#ifdef HAVE_FFTW
+  static std::atomic<unsigned> planner_flags = FFTW_ESTIMATE;
+  static std::string wisdom_path; ///< Where measured plans are saved, guarded by the planner lock
+#endif
+
+  /**
+   * Constructor for fft_plan.
+   */
+  fft_plan::fft_plan(size_t size, bool forward, size_t howmany) :
+    n(size),
+    howmany(howmany) {
+    size_t alignment = volk_get_alignment();
+    in = static_cast<std::complex<float>*>(volk_malloc(n * howmany * sizeof(std::complex<float>), alignment));
+    out = static_cast<std::complex<float>*>(volk_malloc(n * howmany * sizeof(std::complex<float>), alignment));
+
+    {
+      std::lock_guard<std::mutex> lock(planner_mutex());
+#ifdef HAVE_FFTW
+      int length = n;
+      plan = fftwf_plan_many_dft(1, &length, howmany, reinterpret_cast<fftwf_complex*>(in), nullptr, 1, n, reinterpret_cast<fftwf_complex*>(out), nullptr, 1, n, forward ? FFTW_FORWARD : FFTW_BACKWARD, planner_flags);
+      // Saved right away, a live capture only stops when it is killed
+      if (!wisdom_path.empty() && !fftwf_export_wisdom_to_filename(wisdom_path.c_str())) {
+        SPDLOG_WARN("Could not save FFTW wisdom to {}", wisdom_path);
+      }
+#else
+      for (size_t i = 0; i < howmany; i++) {
+        plans.push_back(fft_create_plan(n, in + i * n, out + i * n, forward ? LIQUID_FFT_FORWARD : LIQUID_FFT_BACKWARD, 0));
+      }
+#endif
+    }
+
+    // Measuring overwrites the buffers
+    std::fill_n(in, n * howmany, 0);
+    std::fill_n(out, n * howmany, 0);
+    SPDLOG_DEBUG("Planned {} {} FFTs of size {}", howmany, forward ? "forward" : "backward", n);
+  }
+
+  /**
+   * Destructor for fft_plan.
+   */
+  fft_plan::~fft_plan() {
+    {
+      std::lock_guard<std::mutex> lock(planner_mutex());
+#ifdef HAVE_FFTW
+      fftwf_destroy_plan(plan);
+#else
+      for (fftplan plan : plans) {
+        fft_destroy_plan(plan);
+      }
+#endif
+    }
+    volk_free(in);
+    volk_free(out);
+  }
+
+  fft_plan& fft_plan::get(size_t size, bool forward, size_t howmany) {
+    thread_local std::map<std::tuple<size_t, bool, size_t>, std::unique_ptr<fft_plan>> plans;
+    auto& plan = plans[{size, forward, howmany}];
+    if (!plan) {
+      plan = std::make_unique<fft_plan>(size, forward, howmany);
+    }
+    return *plan;
+  }
+
+  void fft_plan::execute() {
+#ifdef HAVE_FFTW
+    fftwf_execute(plan);
+#else
+    for (fftplan plan : plans) {
+      fft_execute(plan);
+    }
+#endif
+  }
+
+  void fft_plan::load_wisdom(const std::string& path) {
+#ifdef HAVE_FFTW
+    std::lock_guard<std::mutex> lock(planner_mutex());
+    bool loaded = fftwf_import_wisdom_from_filename(path.c_str());
+    // Measuring only pays off if the result can be kept for the next run
+    if (!fftwf_export_wisdom_to_filename(path.c_str())) {
+      SPDLOG_WARN("Cannot save FFTW wisdom to {}, FFTs are planned without measuring", path);
+      return;
+    }
+    wisdom_path = path;
+    planner_flags = FFTW_MEASURE;
+    if (loaded) {
+      SPDLOG_INFO("Loaded FFTW wisdom from {}", path);
+    } else {
+      SPDLOG_INFO("No FFTW wisdom in {} yet, new FFTs are measured and saved there", path);
+    }
+#endif
+  }
+}
@@ -98,8 +98,17 @@ void flow::finish() {
  * @param samples shared_ptr to sample buffer
  */
 void flow::process(shared_ptr<vector<complex<float>>>& samples, int64_t metadata_) {
+  process(sample_view(samples), metadata_);
+}
+
+/** 
+ * Copies the viewed samples straight into the message to the flow thread.
+ *
+ * @param samples view of the samples to send
+ */
+void flow::process(const sample_view& samples, int64_t metadata_) {
   zmq::message_t identifier(routing_id);
-  zmq::message_t payload(samples->begin(), samples->end()); // I MIGHT HAVE TO ADD THE METADATA HERE.
+  zmq::message_t payload(samples.samples().begin(), samples.samples().end()); // I MIGHT HAVE TO ADD THE METADATA HERE.
   // payload.append(metadata_);
   metadata = metadata_;
   // zmq::message_t meta(metadata_);
@@ -1,5 +1,6 @@
 #include "flow_pool.h"
 #include <cstdint>
+#include <algorithm>
 #include <exception>
 #include <memory>
 #include <spdlog/spdlog.h>
@@ -58,6 +59,18 @@ namespace nr {
     throw sniffer_exception("Flow pool semaphore indicated a flow is available, but this was not the case.");
   }
 
+  /** 
+  * Tells a single acquired flow to finish processing after its current
+  * workload.
+  */
+  void flow_pool::release_flow(shared_ptr<flow> f) {
+    auto it = std::find(this->acquired_flows.begin(), this->acquired_flows.end(), f);
+    if (it != this->acquired_flows.end()) {
+      (*it)->finish();
+      this->acquired_flows.erase(it);
+    }
+  }
+
   void flow_pool::release_flows() {
     for (vector<shared_ptr<flow>>::iterator it = this->acquired_flows.begin(); it != this->acquired_flows.end(); ++it) {
       (*it)->finish();
@@ -76,4 +89,51 @@ namespace nr {
       (*it)->process(samples, metadata_);
     }
   }
-}
\ No newline at end of file
+
+  /** 
+  * Sends a view of samples to all acquired flows, without copying it.
+  *
+  * @param samples view of the samples to send
+  */
+  void flow_pool::process(const sample_view& samples, int64_t metadata_) {
+    for (vector<shared_ptr<flow>>::iterator it = this->acquired_flows.begin(); it != this->acquired_flows.end(); ++it) {
+      (*it)->process(samples, metadata_);
+    }
+  }
+
+  /** 
+  * Constructor for flow_group.
+  */
+  flow_group::flow_group(shared_ptr<flow_pool> pool) :
+    pool(pool) {
+  }
+
+  flow_group::~flow_group() {
+    this->release_flows();
+  }
+
+  shared_ptr<flow> flow_group::acquire_flow() {
+    auto f = pool->acquire_flow();
+    this->flows.push_back(f);
+    return f;
+  }
+
+  void flow_group::release_flows() {
+    for (auto& f : this->flows) {
+      pool->release_flow(f);
+    }
+    this->flows.clear();
+  }
+
+  void flow_group::process(shared_ptr<vector<complex<float>>>& samples, int64_t metadata_) {
+    for (auto& f : this->flows) {
+      f->process(samples, metadata_);
+    }
+  }
+
+  void flow_group::process(const sample_view& samples, int64_t metadata_) {
+    for (auto& f : this->flows) {
+      f->process(samples, metadata_);
+    }
+  }
+}
@@ -0,0 +1,30 @@
+#include "gscn.h"
+#include <cmath>
+
+namespace nr {
+  static constexpr double usable_bandwidth = 0.8; // Fraction of the sample rate not attenuated by the front-end filters
+
+  double gscn_to_frequency(uint32_t gscn) {
+    if (gscn < 7499) {
+      // N * 1200 kHz + M * 50 kHz, with GSCN = 3N + (M - 3) / 2
+      uint32_t n = (gscn + 1) / 3;
+      int32_t m = 3 + 2 * (static_cast<int32_t>(gscn) - static_cast<int32_t>(3 * n));
+      return n * 1'200'000.0 + m * 50'000.0;
+    } else if (gscn < 22256) {
+      return 3'000'000'000.0 + (gscn - 7499) * 1'440'000.0;
+    } else {
+      return 24'250'080'000.0 + (gscn - 22256) * 17'280'000.0;
+    }
+  }
+
+  std::vector<uint32_t> gscn_raster(double center_frequency, uint64_t sample_rate, double ssb_bandwidth) {
+    std::vector<uint32_t> raster;
+    double max_offset = (usable_bandwidth * sample_rate - ssb_bandwidth) / 2;
+    for (uint32_t gscn = gscn_min; gscn <= gscn_max; gscn++) {
+      if (std::abs(gscn_to_frequency(gscn) - center_frequency) <= max_offset) {
+        raster.push_back(gscn);
+      }
+    }
+    return raster;
+  }
+}
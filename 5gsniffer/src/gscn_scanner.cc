@@ -0,0 +1,166 @@
+#include "gscn_scanner.h"
+#include "bandwidth_part.h"
+#include "cell_detector.h"
+#include "decimator.h"
+#include "dsp.h"
+#include "exceptions.h"
+#include "ofdm.h"
+#include "phy.h"
+#include "phy_params_common.h"
+#include "ssb_mapper.h"
+#include <algorithm>
+#include <cmath>
+#include <numbers>
+#include <spdlog/spdlog.h>
+
+namespace nr {
+  static constexpr unsigned int scanner_h_len = 51; // Resampling filter semi-length, as in the syncer
+  static constexpr float ssb_period = 0.02; // SSB periodicity for initial access
+  static constexpr size_t max_cells_per_channel = 16;
+
+  /**
+   * Constructor for gscn_scanner.
+   */
+  gscn_scanner::gscn_scanner(uint64_t sample_rate, double center_frequency, uint16_t ssb_numerology, float threshold, size_t num_threads) :
+    sample_rate(sample_rate),
+    ssb_numerology(ssb_numerology),
+    ssb_sample_rate(3'840'000 * (1<<ssb_numerology)),
+    threshold(threshold),
+    exec(std::make_unique<executor>(num_threads)) {
+    if (ssb_sample_rate > sample_rate) {
+      throw sniffer_exception("The sample rate is too low for the SSB numerology");
+    }
+
+    double ssb_bandwidth = ssb_sc * 15'000.0 * (1<<ssb_numerology);
+    for (uint32_t gscn : gscn_raster(center_frequency, sample_rate, ssb_bandwidth)) {
+      double frequency = gscn_to_frequency(gscn);
+      channels.push_back({gscn, frequency, frequency - center_frequency});
+    }
+    SPDLOG_INFO("Scanning {} GSCN raster positions from {} to {} with {} threads", channels.size(), channels.empty() ? 0 : channels.front().gscn, channels.empty() ? 0 : channels.back().gscn, exec->get_num_threads());
+  }
+
+  /**
+   * An SSB period, so that an SSB of every cell is seen, and the 10 symbols
+   * the PBCH is decoded from, plus the delay of the resampling filter.
+   */
+  size_t gscn_scanner::get_num_samples() const {
+    bandwidth_part ssb_bwp(sample_rate, ssb_numerology, ssb_rb);
+    size_t ssb_num_samples = 12 * ssb_bwp.samples_per_symbol(1);
+    return std::ceil(sample_rate * ssb_period) + ssb_num_samples + 2 * scanner_h_len;
+  }
+
+  std::vector<gscn_scanner::result> gscn_scanner::scan(std::span<std::complex<float>> samples, uint8_t nid_2) {
+    // Every raster position is processed as one task, with results of its own
+    std::vector<std::vector<result>> channel_results(channels.size());
+    task_group group(exec.get());
+    for (size_t i = 0; i < channels.size(); i++) {
+      group.run([this, i, samples, nid_2, &channel_results]() {
+        scan_channel(channels[i], samples, nid_2, channel_results[i]);
+      });
+    }
+    group.wait();
+
+    // Raster positions are 100 kHz apart below 3 GHz, so a strong cell can also be found at its neighbours. Keep the best one.
+    std::vector<result> results;
+    for (const auto& rs : channel_results) {
+      for (const auto& r : rs) {
+        auto it = std::find_if(results.begin(), results.end(), [&r](const result& other) {
+          return other.cell_id == r.cell_id && std::abs(other.frequency - r.frequency) < 1'000'000.0;
+        });
+        if (it == results.end()) {
+          results.push_back(r);
+        } else if (r.snr_db > it->snr_db) {
+          *it = r;
+        }
+      }
+    }
+    return results;
+  }
+
+  /**
+   * Finds the cells at one raster position.
+   */
+  void gscn_scanner::scan_channel(const channel& ch, std::span<std::complex<float>> samples, uint8_t nid_2, std::vector<result>& results) {
+    // Mix the raster position to baseband
+    std::vector<std::complex<float>> shifted(samples.size());
+    rotate(shifted, samples, -ch.offset, sample_rate);
+
+    // Downsample to the SSB rate, with the filter cutoff at the edge of the SSB
+    float bw = (ssb_sc * 15'000.0f * (1<<ssb_numerology) / 2) / sample_rate;
+    decimator downsampler(sample_rate, ssb_sample_rate, scanner_h_len, bw, 70.0f, 16);
+    std::vector<std::complex<float>> downsampled;
+    downsampled.reserve(samples.size() * downsampler.get_rate() + 1);
+    downsampler.execute(shifted, downsampled);
+
+    // Skip the start-up of the filter
+    size_t transient = std::ceil(downsampler.get_delay() * downsampler.get_rate());
+    if (downsampled.size() <= transient) {
+      return;
+    }
+    std::span<const std::complex<float>> stream(downsampled.data() + transient, downsampled.size() - transient);
+
+    bandwidth_part ssb_bwp(ssb_sample_rate, ssb_numerology, ssb_rb);
+    cell_detector detector(threshold, max_cells_per_channel, ssb_bwp.samples_per_cp(4));
+    std::vector<cell_detector::detection> detections;
+    detector.detect(detections, stream);
+
+    for (const auto& d : detections) {
+      if (nid_2 <= nid_2_max && d.nid2 != nid_2) {
+        continue;
+      }
+
+      float rho = std::min(d.sss_correlation, 0.999f);
+      result r = {ch.gscn, ch.frequency, d.get_cell_id(), 10 * std::log10(rho * rho / (1 - rho * rho)), 0.0f, false, {}};
+
+      // The PBCH is decoded from 10 symbols from the CP of the PSS on, as in the syncer
+      size_t cp_length = ssb_bwp.samples_per_cp(2);
+      if (d.pss_position >= cp_length && d.pss_position - cp_length + ssb_nfft * 10 <= stream.size()) {
+        auto begin = stream.begin() + (d.pss_position - cp_length);
+        std::vector<std::complex<float>> ssb(begin, begin + ssb_nfft * 10);
+        decode_mib(r, d.nid1, d.nid2, ssb);
+      }
+
+      SPDLOG_INFO("GSCN {} ({:.3f} MHz): cell ID {}, SNR {:.1f} dB, CFO {:.0f} Hz, MIB {}", ch.gscn, ch.frequency / 1e6, r.cell_id, r.snr_db, r.cfo, r.mib_found ? "decoded" : "not decoded");
+      results.push_back(r);
+    }
+  }
+
+  /**
+   * Corrects the fine CFO of an SSB that starts at the CP of its PSS, as
+   * syncer::fine_sync does, and decodes its PBCH.
+   */
+  bool gscn_scanner::decode_mib(result& r, uint16_t nid1, uint8_t nid2, std::vector<std::complex<float>>& ssb) {
+    auto ssb_bwp = std::make_shared<bandwidth_part>(ssb_sample_rate, ssb_numerology, ssb_rb);
+    uint16_t useful_length = ssb_bwp->fft_size;
+    uint16_t cp_length = ssb_bwp->samples_per_cp(1);
+    uint16_t symbol_length = useful_length + cp_length;
+
+    std::vector<std::complex<float>> correlations;
+    moving_correlate_delayed(correlations, ssb, useful_length, cp_length);
+    std::complex<float> average = correlations[symbol_length*1] + correlations[symbol_length*2] + correlations[symbol_length*3] + correlations[symbol_length*4];
+    r.cfo = ssb_bwp->scs * (std::arg(average) / (2*std::numbers::pi));
+    rotate(ssb, ssb, -r.cfo, ssb_sample_rate);
+
+    // The cell ID is known, so the SSB mapper goes straight to the PBCH
+    auto phy = std::make_shared<nr::phy>();
+    phy->ssb_bwp = ssb_bwp;
+    phy->nid1 = nid1;
+    phy->nid2 = nid2;
+    phy->in_synch = true;
+
+    ofdm demodulator(ssb_bwp);
+    demodulator.symbol_index = 2; // Aligned to the PSS, which is the 3rd symbol in the SSB
+    auto mapper = std::make_shared<ssb_mapper>(phy);
+    mapper->pbch.on_mib_found = [&r](srsran_mib_nr_t& mib, bool found) {
+      r.mib_found = found;
+      if (found) {
+        r.mib = mib;
+      }
+    };
+    demodulator.connect(mapper);
+
+    auto ssb_ptr = std::make_shared<std::vector<std::complex<float>>>(std::move(ssb));
+    demodulator.process(ssb_ptr, 0);
+    return r.mib_found;
+  }
+}
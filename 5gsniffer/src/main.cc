@@ -9,6 +9,7 @@
 #include "sniffer.h"
 #include "exceptions.h"
 #include "config.h"
+#include "fft_plan.h"
 
 using namespace std;
 extern struct config config;
@@ -50,6 +51,9 @@ int main(int argc, char** argv) {
   try {
     // Load the config
     config = config::load(config_path);
+    if (!config.fft_wisdom_path.empty()) {
+      nr::fft_plan::load_wisdom(config.fft_wisdom_path);
+    }
 
     // Create sniffer
     if(config.file_path.compare("") == 0) {
@@ -1,11 +1,15 @@
+#include <algorithm>
+#include <cassert>
 #include <complex>
 #include <cstdint>
 #include <vector>
 #include <span>
 #include <spdlog/spdlog.h>
 #include "ofdm.h"
+#include "fft_plan.h"
 #include "utils.h"
 #include "symbol.h"
+#include "slot_grid.h"
 
 /** 
  * Constructor for ofdm.
@@ -30,78 +34,124 @@ ofdm::~ofdm() {
 }
 
 
-// /** 
-//  * Transform samples into OFDM symbols. More efficient implementation. Does not support fractional CP removal.
-//  *
-//  * @param samples shared_ptr to sample buffer to process
-//  * @param metadata for future work
-//  */
+/** 
+ * Transform samples into OFDM symbols, which are passed on as one grid per
+ * buffer. Does not support fractional CP removal.
+ *
+ * @param samples shared_ptr to sample buffer to process
+ * @param metadata for future work
+ */
 void ofdm::process(shared_ptr<vector<complex<float>>>& samples, int64_t metadata) {
   SPDLOG_DEBUG("Starting OFDM demodulation");
+  span<const complex<float>> input(*samples);
 
-  vector<symbol> produced_symbols;
-  produced_symbols.reserve(samples->size() / bwp->samples_per_symbol(1)); // Reserve space for worst case number of symbols
-  int symbol_ctr = 0;
-  vector<complex<float>> input_data(bwp->fft_size);
-  vector<complex<float>> symbol_fft_full(bwp->fft_size);
-
-  int flags = 0;
-  fftplan q = fft_create_plan(bwp->fft_size, (input_data.data()), symbol_fft_full.data(), LIQUID_FFT_FORWARD, flags);
+  // The grid is reused, unless a next worker kept the previous one
+  if (!grid || grid.use_count() > 1) {
+    grid = make_shared<slot_grid>();
+  }
+  grid->reset(bwp->num_subcarriers);
+  grid->reserve((leftover_samples.size() + input.size()) / bwp->samples_per_symbol(1) + 1); // Worst case number of symbols
 
-  int num_leftover_samp = leftover_samples.size();
   // If there are leftover samples from a previous buffer, we should process that OFDM symbol first, as pre-appending the leftover
   // samples to the new incoming buffer is expensive.
-  
-  while (samples->size() - symbol_ctr >= bwp->samples_per_symbol(symbol_index)) {
-    // Keep track of OFDM symbol start, and copy new symbol
-    int curr_position = symbol_ctr + bwp->samples_per_cp(symbol_index);
-    vector<complex<float>> symbol_fft;
-    symbol_fft.reserve(bwp->num_subcarriers);
-
-    if (leftover_samples.size() > 0){
-      leftover_samples.insert(leftover_samples.end(), samples->begin(), samples->begin() + (bwp->samples_per_symbol(symbol_index) - leftover_samples.size()));
-      std::copy(leftover_samples.begin() + curr_position, leftover_samples.begin() + curr_position + bwp->fft_size, input_data.begin());
-      symbol_ctr = symbol_ctr - num_leftover_samp;
+  size_t position = 0;
+  if (!leftover_samples.empty()) {
+    position = std::min<size_t>(bwp->samples_per_symbol(symbol_index) - leftover_samples.size(), input.size());
+    leftover_samples.insert(leftover_samples.end(), input.begin(), input.begin() + position);
+    if (demodulate(*grid, leftover_samples) > 0) {
       leftover_samples.clear();
-    }else{
-      std::copy(samples->begin() + curr_position, samples->begin() + curr_position + bwp->fft_size, input_data.begin());
     }
-    // Perform FFT  
-    fft_execute(q);
-    
-    // FFT shift + extract subcarriers
-    symbol_fft.insert(symbol_fft.end(), symbol_fft_full.end() - (bwp->num_subcarriers/2), symbol_fft_full.end());
-    symbol_fft.insert(symbol_fft.end(), symbol_fft_full.begin(), symbol_fft_full.begin() + (bwp->num_subcarriers/2));
-
-    // Create symbol class and add to vector
-    symbol s;
-    s.sample_index = this->samples_processed;
-    s.samples = std::move(symbol_fft);
-    s.symbol_index = symbol_index;
-    s.slot_index = slot_index;
-    produced_symbols.push_back(std::move(s));
+  }
+  if (leftover_samples.empty()) {
+    position += demodulate(*grid, input.subspan(position));
 
-    // Counter for OFDM symbol and slot number
-    symbol_ctr = symbol_ctr + bwp->samples_per_symbol(symbol_index);
+    // Keeping leftover samples for next input
+    leftover_samples.assign(input.begin() + position, input.end());
+  }
 
-    symbol_index += 1;
-    if(symbol_index == bwp->symbols_per_slot) {
-      slot_index = (slot_index + 1) % bwp->slots_per_frame;
+  // Pass produced symbols on to symbol workers
+  if (!grid->empty())
+    send_to_next_workers(grid, metadata);
+}
+
+
+/** 
+ * Only the symbols at the given indices in the slot are demodulated, the
+ * others are skipped over. All symbols are demodulated if none are given.
+ */
+void ofdm::set_symbol_indices(span<const uint8_t> symbol_indices) {
+  symbol_mask = symbol_indices.empty() ? ~0u : 0u;
+  for (uint8_t l : symbol_indices) {
+    assert(l < bwp->symbols_per_slot);
+    symbol_mask |= 1u << l;
+  }
+}
+
+
+/** 
+ * Demodulates the whole symbols at the start of samples into grid. The
+ * needed symbols of a slot are transformed by a single batched FFT.
+ *
+ * @return number of samples demodulated or skipped
+ */
+size_t ofdm::demodulate(slot_grid& grid, span<const complex<float>> samples) {
+  size_t position = 0;
+  size_t half = bwp->num_subcarriers / 2;
+  while (true) {
+    // The rest of the current slot, as far as samples go
+    size_t count = 0;
+    size_t num_needed = 0;
+    size_t end = position;
+    while (symbol_index + count < bwp->symbols_per_slot && end + bwp->samples_per_symbol(symbol_index + count) <= samples.size()) {
+      end += bwp->samples_per_symbol(symbol_index + count);
+      num_needed += is_needed(symbol_index + count);
+      count++;
+    }
+    if (count == 0) {
+      break;
+    }
+
+    if (num_needed > 0) {
+      // Useful part of every needed symbol, one after the other
+      nr::fft_plan& fft = nr::fft_plan::get(bwp->fft_size, true, num_needed);
+      auto input = fft.input();
+      size_t symbol_start = position;
+      for (size_t i = 0, j = 0; i < count; i++) {
+        if (is_needed(symbol_index + i)) {
+          std::copy_n(samples.begin() + symbol_start + bwp->samples_per_cp(symbol_index + i), bwp->fft_size, input.begin() + j * bwp->fft_size);
+          j++;
+        }
+        symbol_start += bwp->samples_per_symbol(symbol_index + i);
+      }
+      fft.execute();
+
+      // FFT shift + extract subcarriers, straight into the grid
+      uint64_t sample_index = samples_processed;
+      for (size_t i = 0, j = 0; i < count; i++) {
+        uint8_t l = symbol_index + i;
+        if (is_needed(l)) {
+          auto spectrum = fft.output().subspan(j * bwp->fft_size, bwp->fft_size);
+          auto row = grid.add_symbol({sample_index, l, slot_index});
+          std::copy(spectrum.end() - half, spectrum.end(), row.begin());
+          std::copy(spectrum.begin(), spectrum.begin() + half, row.begin() + half);
+          j++;
+        }
+        sample_index += bwp->samples_per_symbol(l);
+      }
     }
-    symbol_index %= bwp->symbols_per_slot;
 
     // Keep track of the total number of samples processed.
-    samples_processed += bwp->samples_per_symbol(symbol_index);
-  }
-  
-  // Keeping leftover samples for next input
-  leftover_samples.insert(leftover_samples.begin(),(*samples.get()).begin() + symbol_ctr - 1, (*samples.get()).end());
-  leftover_samples.resize((*samples).size() - symbol_ctr);
-  // Pass produced symbols on to symbol workers
-  fft_destroy_plan(q);
+    samples_processed += end - position;
 
-  if (produced_symbols.size() > 0)
-    send_to_next_workers(make_shared<vector<symbol>>(std::move(produced_symbols)), metadata);
+    // Counter for OFDM symbol and slot number
+    symbol_index += count;
+    if(symbol_index == bwp->symbols_per_slot) {
+      slot_index = (slot_index + 1) % bwp->slots_per_frame;
+      symbol_index = 0;
+    }
+    position = end;
+  }
+  return position;
 }
 
 
@@ -113,26 +163,20 @@ vector<complex<float>> ofdm::modulate(vector<symbol>& symbols) {
   time_samples.reserve(symbols.size() * (bwp->fft_size + bwp->samples_per_cp(0))); // Reserve space for worst case number of symbols
 
   //Compute IFFT of each symbol, add CP at the end, and concatenate all OFDM symbols. Input Grid assumed padded to FFT size.
-  for (symbol symbol: symbols) {
-    vector<complex<float>> symbol_freq = symbol.samples;
-    vector<complex<float>> symbol_time(bwp->fft_size + bwp->samples_per_cp(symbol.symbol_index),0);
+  nr::fft_plan& ifft = nr::fft_plan::get(bwp->fft_size, false);
+  for (const symbol& symbol: symbols) {
+    auto symbol_freq = ifft.input();
+    auto symbol_time = ifft.output();
 
     /*Perform ifft shift before the transform*/
-    std::rotate(symbol_freq.begin(), symbol_freq.begin() + (bwp->fft_size)/2, symbol_freq.end());
-    
-    /*Create liquid FFT plan*/
-    int flags = 0;
-    fftplan q = fft_create_plan(bwp->fft_size, symbol_freq.data(), symbol_time.data(), LIQUID_FFT_BACKWARD, flags);
+    std::rotate_copy(symbol.samples.begin(), symbol.samples.begin() + (bwp->fft_size)/2, symbol.samples.end(), symbol_freq.begin());
 
     /*execute IFFT*/ 
-    fft_execute(q);
-    /*destroy FFT plan*/
-    fft_destroy_plan(q);
-
-    // Adding Cyclic Prefix samples
-    vector<complex<float>> CP(symbol_time.end() - bwp->samples_per_cp(symbol.symbol_index), symbol_time.end());
-    CP.insert(CP.end(), symbol_time.begin(), symbol_time.end()); // Appending the symbol itself to the CP so we avoid inserting at the beginning (inefficient)
-    time_samples.insert(time_samples.end(), CP.begin(), CP.end());
+    ifft.execute();
+
+    // Adding Cyclic Prefix samples, taken from the end of the symbol
+    time_samples.insert(time_samples.end(), symbol_time.end() - bwp->samples_per_cp(symbol.symbol_index), symbol_time.end());
+    time_samples.insert(time_samples.end(), symbol_time.begin(), symbol_time.end());
   }
   return time_samples;
 }
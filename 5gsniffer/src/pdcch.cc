@@ -1,4 +1,8 @@
 #include "pdcch.h"
+#include "pdcch_decoder_pool.h"
+#include "scrambling_id_solver.h"
+#include "decode_scheduler.h"
+#include "dci_event_pipeline.h"
 #include "coreset.h"
 #include "dsp.h"
 #include "utils.h"
@@ -8,12 +12,18 @@
 #include <numeric>
 #include <execution>
 #include <unordered_map>
+#include <algorithm>
+#include <iterator>
 
 // MHZ - Import
 #include "rnti_tracker.hpp"
 #include "config.h"
 
-std::binary_semaphore rnti_list_mutex(1);
+
+// Polar decoder contexts are built once per flow thread and reused for every
+// RNTI trial, instead of being initialized and freed for each decode attempt.
+static thread_local nr::pdcch_decoder_pool decoder_pool;
+static thread_local nr::dmrs_correlation_batch correlation_batch;
 
 namespace nr {
   pdcch::pdcch() {
@@ -29,7 +39,24 @@ namespace nr {
     sc_power_decision = false;
     max_rnti_queue_size = 65535;
     AL_corr_thresholds = {0.9, 0.8, 0.7, 0.15, 0.15};
-    found_RNTI_list.reserve(1<<15);
+    rnti_aging_ms = 0;
+    slot_budget_us = 0;
+    rnti_epoch = 0;
+    rnti_recovery = false;
+    use_scrambling_id_solver = false;
+    dmrs_cache_size_mb = 64;
+    dmrs_prefetch = true;
+    hierarchical_search = false;
+    hierarchical_energy_ratio = 0.5;
+    discovery_ms = 0;
+    rescan_period_ms = 0;
+    rescan_ms = 0;
+    filtered_rntis_version = 0;
+    rnti_recovery_min_hits = 2;
+    rnti_recovery_window_ms = 1000;
+    RNTI_confirmed_at.assign(1<<16, -1);
+    recovered_RNTI_hits.assign(1<<16, 0);
+    recovered_RNTI_last_seen.assign(1<<16, 0);
   }
 
   pdcch::pdcch(uint16_t RNTI_, coreset coreset_info_) : pdcch() {
@@ -41,7 +68,8 @@ namespace nr {
   * Destructor for pdcch.
   */
   pdcch::~pdcch() {
-
+    // Stop the prefetch thread before the state it generates from is destroyed
+    dmrs_cache.reset();
   }
 
   void pdcch::set_RNTI(uint16_t RNTI_) {
@@ -64,11 +92,12 @@ namespace nr {
   void pdcch::initialize_dmrs_seq() { 
 
     auto init_dmrs_t0 = time_profile_start();
-    dmrs dmrs_pdcch;
-    uint8_t symbol_index = coreset_info.get_starting_ofdm_symbol_within_slot();
+    // Normal CP. Set once, before the prefetch thread reads it to generate references.
+    coreset_info.set_num_symbols_per_slot(14);
     uint16_t scrambling_id = scrambling_id_start;
     bool user_search_space = false;
-    uint8_t coreset_duration = coreset_info.get_duration();
+
+    dmrs_table.reset(coreset_info.get_num_slots_per_frame(), coreset_info.get_candidates_search_space());
 
     for (uint8_t slot_index = 0 ; slot_index < coreset_info.get_num_slots_per_frame(); slot_index++) {
       for (int agg_level = 0; agg_level < NUM_ALs; agg_level++) {
@@ -76,38 +105,143 @@ namespace nr {
         uint8_t max_num_candidate = coreset_info.get_candidates_search_space().at(agg_level);
 
         for (int candidate_idx = 0; candidate_idx < max_num_candidate; candidate_idx++) {
-          std::vector<uint16_t> pdcch_dmrs_rb_indices;
-          std::vector<uint64_t> pdcch_dmrs_sc_indices;
-          std::vector<uint16_t> pdcch_data_sc_indices;
+          std::vector<uint16_t> pdcch_dmrs_rb_indices = get_dmrs_rb_indices(1<<agg_level, candidate_idx, max_num_candidate, slot_index, user_search_space);
+          std::vector<uint64_t> pdcch_dmrs_sc_indices = get_dmrs_sc_indices(1<<agg_level, candidate_idx, max_num_candidate, slot_index, user_search_space);
+          std::vector<uint16_t> pdcch_data_sc_indices = get_data_sc_indices(1<<agg_level, candidate_idx, max_num_candidate, slot_index, user_search_space);
 
-          pdcch_dmrs_rb_indices = get_dmrs_rb_indices(1<<agg_level, candidate_idx, max_num_candidate, slot_index, user_search_space);
-          pdcch_dmrs_sc_indices = get_dmrs_sc_indices(1<<agg_level, candidate_idx, max_num_candidate, slot_index, user_search_space);
-          pdcch_data_sc_indices = get_data_sc_indices(1<<agg_level, candidate_idx, max_num_candidate, slot_index, user_search_space);
+          dmrs_table.add(slot_index, agg_level, candidate_idx, pdcch_dmrs_sc_indices, pdcch_data_sc_indices, pdcch_dmrs_rb_indices);
+        }
+      }
+    }
 
-          std::vector<std::complex<float>> pdcch_dmrs_symbols = {};
-          pdcch_dmrs_symbols.reserve(pdcch_dmrs_rb_indices.size());
+    dmrs_table.link_parents();
 
-          for (uint8_t dur_idx = 0; dur_idx < coreset_duration ; dur_idx++) {
-            std::vector<std::complex<float>> pdcch_dmrs_symbols_al_max = dmrs_pdcch.generate_pdcch_dmrs_symb(scrambling_id, slot_index, symbol_index+dur_idx, coreset_info.get_num_symbols_per_slot(), 2*AL_16*18);
-            for (int i_idx = 0 ; i_idx < (pdcch_dmrs_rb_indices.size() / coreset_duration); i_idx++) {
-              pdcch_dmrs_symbols.push_back(pdcch_dmrs_symbols_al_max.at(pdcch_dmrs_rb_indices.at(i_idx)));
-            }
-          }
-          std::string key = std::to_string(scrambling_id) + std::to_string(agg_level) + std::to_string(slot_index) + std::to_string(candidate_idx);
-          
-          this->dmrs_seq_table.emplace(key, pdcch_dmrs_symbols);
-          this->dmrs_sc_indices_table.emplace(key, pdcch_dmrs_sc_indices);
-          this->data_sc_indices_table.emplace(key, pdcch_data_sc_indices);
+    // References are generated per (scrambling ID, slot) on first use
+    dmrs_cache = std::make_shared<pdcch_dmrs_cache>([this](uint16_t scrambling_id, uint8_t slot_index) {
+      return generate_dmrs_references(scrambling_id, slot_index);
+    }, static_cast<size_t>(dmrs_cache_size_mb) << 20);
+    for (uint8_t slot_index = 0 ; slot_index < coreset_info.get_num_slots_per_frame(); slot_index++) {
+      dmrs_cache->get(scrambling_id, slot_index);
+    }
+
+    time_profile_end(init_dmrs_t0, "pdcch::initialize_dmrs_seq");
+  }
+
+  /**
+  * Generates the DMRS reference of a candidate for every OFDM symbol of the CORESET.
+  *
+  * @param output DMRS symbols, one per DMRS RE of the candidate
+  * @param sequences DMRS sequence of each OFDM symbol of the CORESET
+  * @param pdcch_dmrs_rb_indices positions of the candidate DMRS within the DMRS sequence
+  */
+  void pdcch::generate_dmrs_symbols(std::vector<std::complex<float>>& output, std::span<const std::vector<std::complex<float>>> sequences, std::span<const uint16_t> pdcch_dmrs_rb_indices) {
+    output.clear();
+    output.reserve(pdcch_dmrs_rb_indices.size());
+
+    for (const std::vector<std::complex<float>>& pdcch_dmrs_symbols_al_max : sequences) {
+      for (int i_idx = 0 ; i_idx < (pdcch_dmrs_rb_indices.size() / sequences.size()); i_idx++) {
+        output.push_back(pdcch_dmrs_symbols_al_max.at(pdcch_dmrs_rb_indices[i_idx]));
+      }
+    }
+  }
+
+  /**
+  * Generates the DMRS references of every candidate for a scrambling ID and slot.
+  * The DMRS sequence of each OFDM symbol is generated once, for all candidates.
+  */
+  std::shared_ptr<pdcch_dmrs_references> pdcch::generate_dmrs_references(uint16_t scrambling_id, uint8_t slot_index) {
+    auto references = std::make_shared<pdcch_dmrs_references>();
+    references->max_candidates = dmrs_table.get_max_candidates();
+    references->offsets.reserve(NUM_ALs * references->max_candidates + 1);
+
+    dmrs dmrs_pdcch;
+    uint8_t symbol_index = coreset_info.get_starting_ofdm_symbol_within_slot();
+    std::vector<std::vector<std::complex<float>>> sequences(coreset_info.get_duration());
+    for (uint8_t dur_idx = 0; dur_idx < sequences.size(); dur_idx++) {
+      sequences.at(dur_idx) = dmrs_pdcch.generate_pdcch_dmrs_symb(scrambling_id, slot_index, symbol_index+dur_idx, coreset_info.get_num_symbols_per_slot(), 2*AL_16*18);
+    }
+
+    std::vector<std::complex<float>> pdcch_dmrs_symbols;
+    for (int agg_level = 0; agg_level < NUM_ALs; agg_level++) {
+      for (int candidate_idx = 0; candidate_idx < references->max_candidates; candidate_idx++) {
+        references->offsets.push_back(references->symbols.size());
+        if (dmrs_table.contains(slot_index, agg_level, candidate_idx)) {
+          generate_dmrs_symbols(pdcch_dmrs_symbols, sequences, dmrs_table.dmrs_rb_indices(slot_index, agg_level, candidate_idx));
+          references->symbols.insert(references->symbols.end(), pdcch_dmrs_symbols.begin(), pdcch_dmrs_symbols.end());
         }
       }
     }
+    references->offsets.push_back(references->symbols.size());
 
-    time_profile_end(init_dmrs_t0, "pdcch::initialize_dmrs_seq");
+    segment_norms(references->norms, references->symbols, references->offsets);
+    return references;
+  }
+
+  /**
+  * Proposes the scrambling ID of the strongest candidates in a symbol by
+  * solving for the DMRS Gold sequence, and confirms it with one correlation.
+  *
+  * @return true if a scrambling ID within the configured range was confirmed
+  */
+  bool pdcch::solve_scrambling_id(symbol& symbol, uint16_t& scrambling_id) {
+    uint8_t coreset_duration = coreset_info.get_duration();
+
+    // Rank candidates by DMRS energy in the first symbol, larger ALs first on ties
+    std::vector<std::tuple<float, int, int>> ranked;
+    for (int agg_level = NUM_ALs - 1; agg_level >= 0; agg_level--) {
+      int max_num_candidate = coreset_info.get_candidates_search_space().at(agg_level);
+      for (int candidate_idx = 0; candidate_idx < max_num_candidate; candidate_idx++) {
+        std::span<uint64_t> pdcch_dmrs_sc_indices = dmrs_table.dmrs_sc_indices(symbol.slot_index, agg_level, candidate_idx);
+        if (pdcch_dmrs_sc_indices.empty()) {
+          continue;
+        }
+        size_t num_res = pdcch_dmrs_sc_indices.size() / coreset_duration;
+        float energy = 0;
+        for (size_t i = 0; i < num_res; i++) {
+          energy += std::norm(symbol.samples.at(pdcch_dmrs_sc_indices[i]));
+        }
+        ranked.emplace_back(energy / num_res, agg_level, candidate_idx);
+      }
+    }
+    std::stable_sort(ranked.begin(), ranked.end(), [](const auto& a, const auto& b) { return std::get<0>(a) > std::get<0>(b); });
+
+    for (size_t attempt = 0; attempt < std::min(ranked.size(), (size_t)max_solver_candidates); attempt++) {
+      auto [energy, agg_level, candidate_idx] = ranked.at(attempt);
+      std::span<uint64_t> pdcch_dmrs_sc_indices = dmrs_table.dmrs_sc_indices(symbol.slot_index, agg_level, candidate_idx);
+      std::span<uint16_t> pdcch_dmrs_rb_indices = dmrs_table.dmrs_rb_indices(symbol.slot_index, agg_level, candidate_idx);
+
+      size_t num_res = pdcch_dmrs_sc_indices.size() / coreset_duration;
+      std::vector<std::complex<float>> rx_dmrs_symbols(num_res);
+      std::vector<uint16_t> seq_indices(pdcch_dmrs_rb_indices.begin(), pdcch_dmrs_rb_indices.begin() + num_res);
+      for (size_t i = 0; i < num_res; i++) {
+        rx_dmrs_symbols.at(i) = symbol.samples.at(pdcch_dmrs_sc_indices[i]);
+      }
+
+      uint16_t n_id = 0;
+      if (!scrambling_id_solver::solve(rx_dmrs_symbols, seq_indices, symbol.slot_index, coreset_info.get_starting_ofdm_symbol_within_slot(), coreset_info.get_num_symbols_per_slot(), n_id)) {
+        continue;
+      }
+      if (n_id < scrambling_id_start || n_id > scrambling_id_end) {
+        SPDLOG_DEBUG("Solved scrambling ID {} outside of the configured range", n_id);
+        continue;
+      }
+
+      std::shared_ptr<const pdcch_dmrs_references> references = dmrs_cache->get(n_id, symbol.slot_index);
+      std::span<std::complex<float>> pdcch_dmrs_symbols = references->get(agg_level, candidate_idx);
+      float correlation = compute_correlation_DMRS(symbol, pdcch_dmrs_symbols, pdcch_dmrs_sc_indices);
+      if (correlation > AL_corr_thresholds.at(agg_level)) {
+        SPDLOG_DEBUG("Solved scrambling ID {} from AL {} candidate {} with correlation {}", n_id, 1<<agg_level, candidate_idx, correlation);
+        scrambling_id = n_id;
+        return true;
+      }
+    }
+    return false;
   }
   
   // MHZ - Initialize the list of RNTI with configurable prioritization
   void pdcch::initialize_RNTI_list() {
-    found_RNTI_list.clear();
+    std::vector<uint16_t> initial_order;
+    initial_order.reserve(rnti_end - rnti_start + 1);
 
     uint16_t ps = 0;
     uint16_t pe = 0;
@@ -124,57 +258,96 @@ namespace nr {
     // MHZ - First, add the priority range
     if (have_priority) {
       for (uint32_t r = ps; r <= pe; ++r) {
-        found_RNTI_list.push_back(static_cast<uint16_t>(r));
+        initial_order.push_back(static_cast<uint16_t>(r));
       }
     }
 
     // MHZ - Then, add the rest of the standard range (avoiding duplicates)
     for (uint32_t r = rnti_start; r <= rnti_end; ++r) {
       if (have_priority && r >= ps && r <= pe) continue;
-      found_RNTI_list.push_back(static_cast<uint16_t>(r));
+      initial_order.push_back(static_cast<uint16_t>(r));
     }
 
+    rnti_list.reset(initial_order);
+    rnti_list.set_max_age(rnti_aging_ms);
+    std::lock_guard<std::mutex> lock(discovery_mutex);
+    decode_rntis.store(rnti_list.snapshot(), std::memory_order_release);
+    filtered_rntis_source = nullptr;
+    discovery.configure(discovery_ms, rescan_period_ms, rescan_ms);
+
     SPDLOG_DEBUG("Initialized RNTI list {}..{}{}, total {}",
            rnti_start, rnti_end,
            have_priority ? fmt::format(" with priority {}..{}", ps, pe) : "",
-           found_RNTI_list.size());
+           initial_order.size());
+  }
+
+  /**
+  * Picks the RNTIs tried in the next chunk: the RNTI list, restricted to the
+  * discovered RNTI blocks outside of full scans. The restricted list is only
+  * rebuilt when the RNTI list or the blocks change. Called with
+  * discovery_mutex held.
+  */
+  void pdcch::select_decode_rntis() {
+    rnti_recency::snapshot_ptr all_rntis = rnti_list.snapshot();
+    if (!discovery.restricts_rntis()) {
+      decode_rntis.store(all_rntis, std::memory_order_release);
+      return;
+    }
+    if (all_rntis == filtered_rntis_source && discovery.get_rnti_blocks_version() == filtered_rntis_version) {
+      return;
+    }
+
+    auto filtered = std::make_shared<std::vector<uint16_t>>();
+    filtered->reserve(discovery.get_num_rnti_blocks() * search_space_discovery::rnti_block_size);
+    std::copy_if(all_rntis->begin(), all_rntis->end(), std::back_inserter(*filtered), [this](uint16_t rnti) { return discovery.contains_rnti(rnti); });
+    decode_rntis.store(filtered, std::memory_order_release);
+    filtered_rntis_source = all_rntis;
+    filtered_rntis_version = discovery.get_rnti_blocks_version();
   }
 
   // Once an RNTI is found, reorder the list of RNTIs to put that RNTI first in the vector
   bool pdcch::update_RNTI_list(uint16_t found_RNTI) {
-    bool rnti_in_list = false;
-
-    rnti_list_mutex.acquire(); // thread-safe
-    std::vector<uint16_t>::iterator position = std::find(found_RNTI_list.begin(), found_RNTI_list.end(), found_RNTI);
-    if (position != found_RNTI_list.end()) { // element not found (this might happen for SI-RNTI, 65535)
-      found_RNTI_list.erase(position);
-      found_RNTI_list.insert(found_RNTI_list.begin(), found_RNTI); // move the RNTI found to index 0
-      rnti_in_list = true;
-    }
-    rnti_list_mutex.release();
-    
-    return rnti_in_list;
+    // Not in the list might happen for SI-RNTI, 65535
+    return rnti_list.promote(found_RNTI, rnti_epoch);
   }
 
+
   /* Look for DCIs across the whole PDCCH region. CORESET duration indicates how many OFDM symbols contain 
   PDCCH and starting OFDM symbol in CORESET indicates where does the PDCCH region start within a slot.
   The DMRS Sequence depends on the OFDM symbol, slot number, scramblingID,  and number of symbols per slot */
 
   void pdcch::process(shared_ptr<vector<symbol>>& symbols, int64_t metadata) {
-    coreset_info.set_num_symbols_per_slot(14);
-    srsran_pdcch_nr_res_t res        = {};
+    // RNTIs age in milliseconds of sample time
+    rnti_epoch = sample_rate_time > 0 ? static_cast<uint32_t>(metadata * 1000 / static_cast<int64_t>(sample_rate_time)) : 0;
+
+    // Coverage is reduced while decoding lags behind the samples
+    lag_controller& controller = lag_controller::instance();
+    if (sample_rate_time > 0) {
+      controller.update(static_cast<double>(metadata) / static_cast<double>(sample_rate_time));
+    }
+    decode_limits limits = {controller.rnti_list_length(rnti_list_length), controller.min_agg_level()};
+
+    // Outside of the discovery window and rescans, only the discovered scrambling IDs and RNTIs are searched
+    {
+      std::lock_guard<std::mutex> lock(discovery_mutex);
+      discovery.update(rnti_epoch);
+      select_decode_rntis();
+    }
+
+    // Every symbol is an independent task, the DCIs found are merged back in symbol order.
+    // This holds without threads too: DCIs are only reported, and their RNTIs promoted, once the chunk is decoded.
+    std::vector<std::vector<decoded_dci>> decoded_per_symbol(symbols->size());
+    task_group symbol_tasks(task_executor.get());
+    for (size_t i = 0; i < symbols->size(); i++) {
+      symbol_tasks.run([this, &symbols, &decoded_per_symbol, &limits, i, metadata]() {
+        process_symbol(symbols->at(i), metadata, limits, decoded_per_symbol.at(i));
+      });
+    }
+    symbol_tasks.wait();
 
-    bool user_search_space = false;
-    bool found_possible_dci = false;
     int symbol_in_chunk = 0;
-    for (symbol& symbol: *symbols) {
+    for (size_t i = 0; i < symbols->size(); i++) {
       symbol_in_chunk++;
-      auto process_symbol_time = time_profile_start();
-    
-      std::vector<dci> found_dci_list;
-
-      auto correlate_dmrs_t0 = time_profile_start();
-      found_possible_dci = correlate_DMRS(symbol, found_dci_list);
 
       // MHZ - Emit RNTI metrics every N seconds
       static double last_emit_s = -1.0;
@@ -201,134 +374,219 @@ namespace nr {
           last_emit_s = now_s;
         }
       }
-      
-
-      time_profile_end(correlate_dmrs_t0, "pdcch::correlate_DMRS (correlations for one symbol)");
-
-      if (found_possible_dci) {
-        srsran_pdcch_nr_res_t res = {};
-        dci aux_dci;
-        uint8_t dci_size;
-        // Decode the DCI list in descendent order of AL to delete lower ALs as we find DCIs
-        for (uint8_t AL = NUM_ALs; AL > 0; AL--) {
-          std::vector<dci> found_dcis = get_found_dci_list_per_AL(1<<(AL-1),found_dci_list);
-          for (int i = 0; i < found_dcis.size(); i ++) {
-            for (int dci_idx = 0; dci_idx < dci_sizes_list.size(); dci_idx++) {
-              dci_size = dci_sizes_list.at(dci_idx);
-
-              // Estimate the channel first, rather than for each RNTI. 
-              auto chest_dci = time_profile_start();
-              aux_dci = found_dcis.at(i);
-              aux_dci.set_nof_bits(dci_size);
-              std::vector<std::complex<float>> equalized_symbols = estimate_channel_dci(symbol, aux_dci);
-              time_profile_end(chest_dci, "pdcch::estimate_channel_dci (equalization for one DCI)");
-
-              // For now we only use the optimized repetition mode for AL above 3 (8).
-              // The dci size will determine which ALs will have repetition, with K, E and N variables.
-              // If the rate matched output is longer than the data, there will be repetition. In this case, we can infer the RNTI without decoding.
-              auto decode_pdcch_t0 = time_profile_start();
-    
-              bool found_dci_ = false;
-              if (AL > 3) {
-                int outp = 0;
-                // SI or RA
-                if (rnti_start < 65520 & rnti_end > 100) {
-                  aux_dci.set_rnti(0);
-                  outp = decode_pdcch(symbol, equalized_symbols, aux_dci, &res, true, metadata, symbol_in_chunk);  
-                } else {
-                  for (int rnti_i = 0; rnti_i < (int)found_RNTI_list.size(); rnti_i++) {
-                    auto rnti = found_RNTI_list.at(rnti_i);
-                    aux_dci.set_rnti(rnti);
-                    outp = decode_pdcch(symbol, equalized_symbols, aux_dci, &res, true, metadata, symbol_in_chunk);
-                  }
-                }     
-                if (outp == 1 && (aux_dci.get_found_aggregation_level() > 1)) {
-                  int deleted_dcis = delete_lower_AL_dcis(aux_dci.get_pdcch_scrambling_id(), aux_dci.get_n_slot(), aux_dci.get_n_ofdm(), aux_dci.get_found_candidate(), aux_dci.get_found_aggregation_level(),found_dci_list);
-                  break;
-                }
-              } else {
-                // TODO: Add config in config file to limit over how many of the most recent RNTI list to look for in AL below 8, tradeoff between speed and missing some DCIs.
-                // int rnti_list_length = 100;
-                // if (AL<=3)
-                //   rnti_list_length = max_rnti_queue_size;
-                for (int rnti_i = 0; rnti_i < std::min(rnti_list_length,(int)found_RNTI_list.size()); rnti_i++) {
-                  auto rnti = found_RNTI_list.at(rnti_i);
-                  aux_dci.set_rnti(rnti);
-                  int outp = decode_pdcch(symbol, equalized_symbols, aux_dci, &res, false, metadata, symbol_in_chunk);
-                  // If the decoding succeeds, delete from the list of Possible DCIs the ones that that have a lower AL and correspond to the DCI just decoded.
-                  // To check this, we check that its the same scrambling_id, slot number, and symbol index, and the candidate_idx is a subset of the decoded candidate
-                  // Also, break after finding a correct RNTI, no need to explore the same DCI for other RNTIs or dci sizes.
-                  if (outp == 1 && (aux_dci.get_found_aggregation_level() > 1)) {
-                    int deleted_dcis = delete_lower_AL_dcis(aux_dci.get_pdcch_scrambling_id(), aux_dci.get_n_slot(), aux_dci.get_n_ofdm(), aux_dci.get_found_candidate(), aux_dci.get_found_aggregation_level(), found_dci_list);
-                    SPDLOG_DEBUG("deleted {} DCIs", deleted_dcis);
-                    // Do not look for more RNTIs in this found_DCI
-                    found_dci_ = true; // Flag to break also dci_size.
-                    break;
-                  }
-                }
-              }
-
-              string decode_pdcch_profile_msg = "pdcch::decode_pdcch (decode of " + to_string(found_RNTI_list.size()) + " RNTIs)";
-              time_profile_end(decode_pdcch_t0, decode_pdcch_profile_msg);
-
-              // Do not look for more DCI sizes in this found_DCI if one was already found
-              if (found_dci_)
-                break;
-            }
-          }
 
+      for (decoded_dci& decoded : decoded_per_symbol.at(i)) {
+        if (!update_RNTI_list(decoded.dci_.get_rnti()) && !decoded.recovered) {
+          SPDLOG_ERROR("Failed to update RNTI list");
         }
+        if (!decoded.recovered) {
+          confirm_rnti(decoded.dci_.get_rnti(), metadata);
+        }
+        {
+          std::lock_guard<std::mutex> lock(discovery_mutex);
+          discovery.record(decoded.dci_.get_pdcch_scrambling_id(), decoded.dci_.get_rnti());
+        }
+        report_dci(symbols->at(i), decoded.dci_, decoded.bits.data(), metadata, symbol_in_chunk);
       }
+    }
+
+    // The next chunk tries the RNTIs found in this one first
+    rnti_list.publish(rnti_epoch);
+    controller.report();
+  }
+
+  /**
+  * Correlates the DMRS of a symbol and decodes its candidates, largest AL first
+  * and most correlated first within an AL. The candidates of an AL are decoded
+  * as parallel tasks, and candidates are shed once the slot budget is spent.
+  *
+  * @param limits decode coverage set by the lag controller
+  * @param decoded DCIs decoded in the symbol, reported by the caller
+  */
+  void pdcch::process_symbol(symbol& symbol, int64_t metadata, const decode_limits& limits, std::vector<decoded_dci>& decoded) {
+    auto process_symbol_time = time_profile_start();
+    decode_deadline deadline(slot_budget_us);
+    lag_controller& controller = lag_controller::instance();
+    std::vector<dci> found_dci_list;
+
+    auto correlate_dmrs_t0 = time_profile_start();
+    bool found_possible_dci = correlate_DMRS(symbol, found_dci_list);
+    time_profile_end(correlate_dmrs_t0, "pdcch::correlate_DMRS (correlations for one symbol)");
+
+    if (found_possible_dci) {
+      // Decode the DCI list in descendent order of AL to delete lower ALs as we find DCIs
+      for (uint8_t AL = NUM_ALs; AL > 0; AL--) {
+        std::vector<dci> found_dcis = get_found_dci_list_per_AL(1<<(AL-1),found_dci_list);
+        if (AL - 1 < limits.min_agg_level) {
+          controller.shed_candidates += found_dcis.size();
+          continue;
+        }
+        // Candidates deferred under a parent that did not decode are correlated now
+        correlate_deferred(symbol, found_dcis);
+        std::vector<std::pair<float, size_t>> by_correlation;
+        for (size_t i = 0; i < found_dcis.size(); i++) {
+          by_correlation.emplace_back(found_dcis.at(i).get_correlation(), i);
+        }
+        std::stable_sort(by_correlation.begin(), by_correlation.end(), [](const auto& a, const auto& b) { return a.first > b.first; });
+        std::vector<dci> sorted_dcis;
+        sorted_dcis.reserve(found_dcis.size());
+        for (auto& [correlation, i] : by_correlation) {
+          sorted_dcis.push_back(found_dcis.at(i));
+        }
+        found_dcis.swap(sorted_dcis);
 
-      found_dci_list.clear(); // Do not process the same DCIs next time
+        std::vector<std::vector<decoded_dci>> decoded_per_candidate(found_dcis.size());
+        std::vector<uint8_t> delete_lower(found_dcis.size(), false);
 
-      time_profile_end(process_symbol_time, "pdcch::process (for one symbol)");
+        task_group candidate_tasks(task_executor.get());
+        for (size_t i = 0; i < found_dcis.size(); i++) {
+          candidate_tasks.run([this, &symbol, &found_dcis, &decoded_per_candidate, &delete_lower, &limits, &deadline, &controller, i, AL, metadata]() {
+            if (deadline.expired()) {
+              controller.shed_candidates++;
+              return;
+            }
+            delete_lower.at(i) = decode_candidate(symbol, found_dcis.at(i), AL, metadata, limits, deadline, decoded_per_candidate.at(i));
+          });
+        }
+        candidate_tasks.wait();
+
+        for (size_t i = 0; i < found_dcis.size(); i++) {
+          decoded.insert(decoded.end(), decoded_per_candidate.at(i).begin(), decoded_per_candidate.at(i).end());
+          // Delete from the list of Possible DCIs the ones that have a lower AL and correspond to the DCI just decoded.
+          if (delete_lower.at(i)) {
+            dci& found = found_dcis.at(i);
+            int deleted_dcis = delete_lower_AL_dcis(found.get_pdcch_scrambling_id(), found.get_n_slot(), found.get_n_ofdm(), found.get_found_candidate(), found.get_found_aggregation_level(), found_dci_list);
+            SPDLOG_DEBUG("deleted {} DCIs", deleted_dcis);
+          }
+        }
+      }
     }
 
+    time_profile_end(process_symbol_time, "pdcch::process (for one symbol)");
   }
 
+  /**
+  * Decodes a candidate for every DCI size and the RNTIs to try.
+  *
+  * @param AL aggregation level index plus one, as iterated by process_symbol
+  * @param deadline decoding stops, and the candidate counts as truncated, once it expires
+  * @return true if a DCI was decoded that makes the contained lower-AL candidates redundant
+  */
+  bool pdcch::decode_candidate(symbol& symbol, const dci& candidate, uint8_t AL, int64_t metadata, const decode_limits& limits, const decode_deadline& deadline, std::vector<decoded_dci>& decoded) {
+    rnti_recency::snapshot_ptr rntis = decode_rntis.load(std::memory_order_acquire);
+    srsran_pdcch_nr_res_t res = {};
+    bool delete_lower = false;
+
+    // The equalized data REs depend only on the candidate, so estimate the channel once for every DCI size and RNTI
+    auto chest_dci = time_profile_start();
+    std::vector<std::complex<float>> equalized_symbols;
+    estimate_channel_dci(symbol, candidate, equalized_symbols);
+    time_profile_end(chest_dci, "pdcch::estimate_channel_dci (equalization for one candidate)");
+
+    for (int dci_idx = 0; dci_idx < dci_sizes_list.size(); dci_idx++) {
+      if (dci_idx > 0 && deadline.expired()) {
+        lag_controller::instance().truncated_candidates++;
+        break;
+      }
+      uint8_t dci_size = dci_sizes_list.at(dci_idx);
+
+      dci aux_dci = candidate;
+      aux_dci.set_nof_bits(dci_size);
+
+      // For now we only use the optimized repetition mode for AL above 3 (8).
+      // The dci size will determine which ALs will have repetition, with K, E and N variables.
+      // If the rate matched output is longer than the data, there will be repetition. In this case, we can infer the RNTI without decoding.
+      auto decode_pdcch_t0 = time_profile_start();
+
+      bool found_dci_ = false;
+      if (rnti_recovery && aux_dci.get_pdcch_scrambling_id() == coreset_info.get_cell_id()) {
+        // Scrambled with the cell ID, the decoded bits do not depend on the RNTI: decode once and read it from the CRC
+        int outp = recover_rnti_pdcch(equalized_symbols, aux_dci, &res, metadata, decoded);
+        if (outp == 1) {
+          delete_lower = aux_dci.get_found_aggregation_level() > 1;
+          found_dci_ = true;
+        }
+      } else if (AL > 3) {
+        int outp = 0;
+        // SI or RA
+        if (rnti_start < 65520 & rnti_end > 100) {
+          aux_dci.set_rnti(0);
+          outp = decode_pdcch(equalized_symbols, aux_dci, &res, true, decoded);
+        } else {
+          for (uint16_t rnti : *rntis) {
+            aux_dci.set_rnti(rnti);
+            outp = decode_pdcch(equalized_symbols, aux_dci, &res, true, decoded);
+          }
+        }
+        if (outp == 1 && (aux_dci.get_found_aggregation_level() > 1)) {
+          delete_lower = true;
+          break;
+        }
+      } else {
+        // TODO: Add config in config file to limit over how many of the most recent RNTI list to look for in AL below 8, tradeoff between speed and missing some DCIs.
+        for (int rnti_i = 0; rnti_i < std::min(limits.rnti_list_length,(int)rntis->size()); rnti_i++) {
+          // Checking the clock every RNTI would cost more than it saves
+          if (rnti_i % deadline_check_interval == deadline_check_interval - 1 && deadline.expired()) {
+            lag_controller::instance().truncated_candidates++;
+            return delete_lower;
+          }
+          auto rnti = rntis->at(rnti_i);
+          aux_dci.set_rnti(rnti);
+          int outp = decode_pdcch(equalized_symbols, aux_dci, &res, false, decoded);
+          // If the decoding succeeds, the lower AL candidates that are a subset of this one are deleted.
+          // Also, break after finding a correct RNTI, no need to explore the same DCI for other RNTIs or dci sizes.
+          if (outp == 1 && (aux_dci.get_found_aggregation_level() > 1)) {
+            delete_lower = true;
+            // Do not look for more RNTIs in this found_DCI
+            found_dci_ = true; // Flag to break also dci_size.
+            break;
+          }
+        }
+      }
 
-  // Function to estimate channel for a given DCI and return the equalized symbols
-  std::vector<std::complex<float>> pdcch::estimate_channel_dci(symbol& symbol, dci dci_) {
-
-      bool user_search_space = false;
-      
-      std::string key = std::to_string(dci_.get_pdcch_scrambling_id()) + std::to_string((uint8_t)log2(dci_.get_found_aggregation_level())) + std::to_string(dci_.get_n_slot()) + std::to_string(dci_.get_found_candidate());
+      string decode_pdcch_profile_msg = "pdcch::decode_pdcch (decode of " + to_string(rntis->size()) + " RNTIs)";
+      time_profile_end(decode_pdcch_t0, decode_pdcch_profile_msg);
 
-      std::vector<uint64_t> pdcch_dmrs_sc_indices = dmrs_sc_indices_table[key];
-      std::vector<std::complex<float>> pdcch_dmrs_symbols = dmrs_seq_table[key];
-      std::vector<uint16_t> pdcch_data_sc_indices = data_sc_indices_table[key];
+      // Do not look for more DCI sizes in this found_DCI if one was already found
+      if (found_dci_)
+        break;
+    }
+    return delete_lower;
+  }
 
-      symbol.channel_estimate(pdcch_dmrs_symbols, pdcch_dmrs_sc_indices, pdcch_data_sc_indices.at(0), pdcch_data_sc_indices.at(pdcch_data_sc_indices.size() - 1 ));
 
-      std::vector<complex<float>> pdcch_rx_symbols = symbol.samples_eq;
-      
-      std::vector<std::complex<float>> pdcch_symbols;
-      pdcch_symbols.reserve(pdcch_data_sc_indices.size());
 
-      for (int i =0; i < pdcch_data_sc_indices.size(); i++) {
-        pdcch_symbols.push_back(pdcch_rx_symbols.at(pdcch_data_sc_indices.at(i)));
-      }
+  // Function to estimate channel for a given DCI candidate and return the equalized data symbols
+  void pdcch::estimate_channel_dci(const symbol& symbol, const dci& dci_, std::vector<std::complex<float>>& pdcch_symbols) {
+      uint8_t agg_level = (uint8_t)log2(dci_.get_found_aggregation_level());
+      std::shared_ptr<const pdcch_dmrs_references> references = dmrs_cache->get(dci_.get_pdcch_scrambling_id(), dci_.get_n_slot());
 
-      return pdcch_symbols;
+      std::span<uint64_t> dmrs_sc = dmrs_table.dmrs_sc_indices(dci_.get_n_slot(), agg_level, dci_.get_found_candidate());
+      std::span<std::complex<float>> dmrs_symbols = references->get(agg_level, dci_.get_found_candidate());
+      std::span<uint16_t> pdcch_data_sc_indices = dmrs_table.data_sc_indices(dci_.get_n_slot(), agg_level, dci_.get_found_candidate());
 
+      symbol.equalize_res(pdcch_symbols, dmrs_symbols, dmrs_sc, pdcch_data_sc_indices);
   }
 
 
   int pdcch::delete_lower_AL_dcis(uint16_t scrambling_id, uint8_t n_slot, uint8_t n_ofdm , uint8_t candidate_idx, uint8_t AL, std::vector<dci>& found_dci_list) {
     int counter = 0;
     bool user_search_space = false;
-    if (coreset_info.get_candidates_search_space().at(1>>AL) > 0) {
-      std::vector<uint16_t> cce_indices = get_candidates(AL, candidate_idx, coreset_info.get_candidates_search_space().at(1>>AL), n_slot, user_search_space);
-      for (auto it = found_dci_list.begin(); it != found_dci_list.end(); it++) {
-        if (it->get_found_aggregation_level() < AL)
-          if ((it->get_n_slot() == n_slot) && (it->get_n_ofdm() == n_ofdm)) {
-            std::vector<uint16_t> lower_AL_cce = get_candidates(it->get_found_aggregation_level(), it->get_found_candidate(), coreset_info.get_candidates_search_space().at(1>>(it->get_found_aggregation_level())), n_slot, user_search_space);
-            if(includes(cce_indices.begin(), cce_indices.end(), lower_AL_cce.begin(), lower_AL_cce.end())) {
-              found_dci_list.erase(it--);
-              counter = counter + 1;
-            }
+    // The search space is indexed by log2 of the AL
+    auto num_candidates = [this](uint8_t AL) { return coreset_info.get_candidates_search_space().at((uint8_t)log2(AL)); };
+    if (num_candidates(AL) > 0) {
+      std::vector<uint16_t> cce_indices = get_candidates(AL, candidate_idx, num_candidates(AL), n_slot, user_search_space);
+      auto it = found_dci_list.begin();
+      while (it != found_dci_list.end()) {
+        if (it->get_found_aggregation_level() < AL && it->get_n_slot() == n_slot && it->get_n_ofdm() == n_ofdm) {
+          std::vector<uint16_t> lower_AL_cce = get_candidates(it->get_found_aggregation_level(), it->get_found_candidate(), num_candidates(it->get_found_aggregation_level()), n_slot, user_search_space);
+          if (includes(cce_indices.begin(), cce_indices.end(), lower_AL_cce.begin(), lower_AL_cce.end())) {
+            it = found_dci_list.erase(it);
+            counter = counter + 1;
+            continue;
           }
+        }
+        it++;
       }
     }
     return counter;
@@ -347,29 +605,101 @@ namespace nr {
   }
 
 
-  int pdcch::decode_pdcch(symbol& symbol, std::vector<std::complex<float>>& pdcch_symbols, dci dci_, srsran_pdcch_nr_res_t* res, bool rep_opt, int64_t metadata, int symbol_in_chunk) {
-    bool user_search_space = false;
+  int pdcch::decode_pdcch(std::vector<std::complex<float>>& pdcch_symbols, dci dci_, srsran_pdcch_nr_res_t* res, bool rep_opt, std::vector<decoded_dci>& decoded) {
+    pdcch_decoder_context& ctx = decode_pdcch_bits(pdcch_symbols, dci_, res, rep_opt);
 
-    srsran_pdcch_nr_args_t args = {};
-    args.disable_simd           = false;
-    args.measure_evm            = false;
-    args.measure_time           = false;
+    // The CRC is masked with the RNTI, so it passes only when the syndrome equals the RNTI
+    res->crc = compute_crc_syndrome(ctx) == dci_.get_rnti();
 
-    srsran_pdcch_nr_t q = {};
-    if (srsran_pdcch_nr_init_rx(&q, &args) < SRSRAN_SUCCESS) {
-      SPDLOG_ERROR("Error init pdcch_rx");
+    if (res->crc) {
+      decoded.push_back({dci_, std::vector<uint8_t>(ctx.q.c + 24, ctx.q.c + 24 + dci_.get_nof_bits()), false});
     }
+    return res->crc;
+  }
 
-    // DCI decoding as in srsRAN library
-    q.K = dci_.get_nof_bits() + 24U;                                      // Payload size including CRC
-    q.M = (dci_.get_found_aggregation_level()) * (PRB_RE - 3U) * CCE_REG; // Number of RE
-    q.E = q.M * 2;                                                        // Number of Rate-Matched bits
+  /**
+  * Decodes a candidate once and reads the RNTI from the CRC parity instead of
+  * trying every RNTI. Only valid when descrambling does not depend on the RNTI,
+  * i.e. when the PDCCH is scrambled with the cell ID.
+  *
+  * @return 1 if a plausible RNTI was recovered, 0 otherwise
+  */
+  int pdcch::recover_rnti_pdcch(std::vector<std::complex<float>>& pdcch_symbols, dci dci_, srsran_pdcch_nr_res_t* res, int64_t metadata, std::vector<decoded_dci>& decoded) {
+    dci_.set_rnti(0);
+    pdcch_decoder_context& ctx = decode_pdcch_bits(pdcch_symbols, dci_, res, false);
+
+    // CRC-24C is linear and the RNTI only masks the last 16 parity bits, so a
+    // correctly decoded DCI leaves 8 zero bits followed by the RNTI.
+    uint32_t syndrome = compute_crc_syndrome(ctx);
+    res->crc = false;
+    if ((syndrome >> 16) != 0) {
+      return 0;
+    }
 
-    // Get polar code
-    if (srsran_polar_code_get(&q.code, q.K, q.E, 9U) < SRSRAN_SUCCESS) {
-      SPDLOG_ERROR("Error init");
+    uint16_t rnti = syndrome & 0xffff;
+    if (!is_plausible_rnti(rnti, metadata)) {
+      SPDLOG_DEBUG("Unconfirmed recovered RNTI {} at AL {}, candidate {}", rnti, dci_.get_found_aggregation_level(), dci_.get_found_candidate());
+      return 0;
     }
 
+    res->crc = true;
+    dci_.set_rnti(rnti);
+    decoded.push_back({dci_, std::vector<uint8_t>(ctx.q.c + 24, ctx.q.c + 24 + dci_.get_nof_bits()), true});
+    return 1;
+  }
+
+  /**
+  * A recovered RNTI passes an 8-bit check only, so random candidates yield one
+  * every 256 decodes. The RNTI is accepted if it is within the configured range
+  * and is confirmed: decoded with a full CRC, or recovered rnti_recovery_min_hits
+  * times within rnti_recovery_window_ms. A confirmation lasts rnti_aging_ms of
+  * sample time, or rnti_recovery_window_ms without aging, so occasional false
+  * recoveries do not keep an RNTI accepted for the rest of the capture.
+  */
+  bool pdcch::is_plausible_rnti(uint16_t rnti, int64_t metadata) {
+    if (rnti < rnti_start || rnti > rnti_end) {
+      return false;
+    }
+
+    const int64_t window = static_cast<int64_t>(rnti_recovery_window_ms) * static_cast<int64_t>(sample_rate_time) / 1000;
+    const int64_t lifetime = static_cast<int64_t>(rnti_aging_ms > 0 ? rnti_aging_ms : rnti_recovery_window_ms) * static_cast<int64_t>(sample_rate_time) / 1000;
+
+    std::lock_guard<std::mutex> lock(recovery_mutex);
+    if (recovered_RNTI_hits[rnti] == 0 || metadata - recovered_RNTI_last_seen[rnti] > window) {
+      recovered_RNTI_hits[rnti] = 0;
+    }
+    // Symbols of the same chunk may carry the same PDCCH, count them once
+    if ((recovered_RNTI_hits[rnti] == 0 || metadata != recovered_RNTI_last_seen[rnti]) && recovered_RNTI_hits[rnti] < UINT8_MAX) {
+      recovered_RNTI_hits[rnti]++;
+    }
+    recovered_RNTI_last_seen[rnti] = metadata;
+    if (recovered_RNTI_hits[rnti] >= rnti_recovery_min_hits) {
+      RNTI_confirmed_at[rnti] = std::max(RNTI_confirmed_at[rnti], metadata);
+    }
+
+    return RNTI_confirmed_at[rnti] >= 0 && metadata - RNTI_confirmed_at[rnti] <= lifetime;
+  }
+
+  /**
+  * Confirms an RNTI decoded with a full CRC, so its recoveries are accepted.
+  */
+  void pdcch::confirm_rnti(uint16_t rnti, int64_t metadata) {
+    std::lock_guard<std::mutex> lock(recovery_mutex);
+    RNTI_confirmed_at[rnti] = std::max(RNTI_confirmed_at[rnti], metadata);
+  }
+
+  /**
+  * Demodulates, descrambles and polar decodes a candidate. The decoded bits,
+  * payload followed by the RNTI-masked CRC, are left in ctx.q.c after 24 leading ones.
+  */
+  pdcch_decoder_context& pdcch::decode_pdcch_bits(std::vector<std::complex<float>>& pdcch_symbols, dci& dci_, srsran_pdcch_nr_res_t* res, bool rep_opt) {
+    // DCI decoding as in srsRAN library. The receiver buffers and polar code
+    // only depend on K and E, so they are reused from this thread's pool.
+    uint32_t K = dci_.get_nof_bits() + 24U;                                      // Payload size including CRC
+    uint32_t M = (dci_.get_found_aggregation_level()) * (PRB_RE - 3U) * CCE_REG; // Number of RE
+    pdcch_decoder_context& ctx = decoder_pool.get(K, M * 2);                     // Number of Rate-Matched bits
+    srsran_pdcch_nr_t& q = ctx.q;
+
     // Demodulation
     int8_t* llr = (int8_t*)q.f;
     srsran_demod_soft_demodulate_b(SRSRAN_MOD_QPSK, (const cf_t *)pdcch_symbols.data(), llr, q.M);
@@ -392,11 +722,12 @@ namespace nr {
       float max_value = 0;
       int max_pos = -1;
       if (q.E > N_length) {
-        int8_t* llr_aux = (int8_t*)malloc(q.E * sizeof(int8_t));  
+        int8_t* llr_aux = ctx.llr_scratch.data();
         auto rep_opt_t0 = time_profile_start();
 
         // This could be parallelized
-        for (auto N_RNTI : found_RNTI_list) {
+        rnti_recency::snapshot_ptr rntis = decode_rntis.load(std::memory_order_acquire);
+        for (auto N_RNTI : *rntis) {
           srsran_sequence_apply_c(llr, llr_aux, q.E, pdcch_nr_c_init_scrambler(N_RNTI, dci_.get_pdcch_scrambling_id()));   
           // Adding up repetition
           int sum = 0;      
@@ -410,8 +741,8 @@ namespace nr {
             max_pos = N_RNTI;
           }
         }
-        if (max_value > 1.05 * (total_sum/(found_RNTI_list.size()))) {
-          SPDLOG_DEBUG("Possible Repetition optimized max value {}, RNTI {}, average {}", max_value, max_pos, (total_sum/(found_RNTI_list.size())));
+        if (max_value > 1.05 * (total_sum/(rntis->size()))) {
+          SPDLOG_DEBUG("Possible Repetition optimized max value {}, RNTI {}, average {}", max_value, max_pos, (total_sum/(rntis->size())));
             dci_.set_rnti(max_pos);
         }
 
@@ -449,132 +780,227 @@ namespace nr {
     // De-interleave
     srsran_polar_interleaver_run(c_prime, c,(uint32_t)sizeof(uint8_t), q.K, false);
 
-    // Unpack RNTI
-    uint8_t  unpacked_rnti[16] = {};
-    uint8_t* ptr               = unpacked_rnti;
-    srsran_bit_unpack(dci_.get_rnti(), &ptr, 16);
-
-    // De-Scramble CRC with RNTI
-    srsran_vec_xor_bbb(unpacked_rnti, &c[q.K - 16], &c[q.K - 16], 16);
+    return ctx;
+  }
 
-    // Check CRC
-    ptr                = &c[q.K - 24];
+  /**
+  * Returns the XOR of the CRC-24C computed over the decoded payload and the
+  * received parity bits. For a correct decode this equals the masking RNTI.
+  */
+  uint32_t pdcch::compute_crc_syndrome(pdcch_decoder_context& ctx) {
+    srsran_pdcch_nr_t& q = ctx.q;
+    uint8_t* ptr       = &q.c[q.K]; // Parity follows the 24 leading ones and the payload
     uint32_t checksum1 = srsran_crc_checksum(&q.crc24c, q.c, q.K);
-
     uint32_t checksum2 = srsran_bit_pack(&ptr, 24);
-    res->crc           = checksum1 == checksum2;
-
-    if (res->crc) {
-      srsran_vec_fprint_hex(stdout, c, dci_.get_nof_bits());
-      char dci_msg_bin[dci_.get_nof_bits() + 1];
-      srsran_vec_sprint_bin(dci_msg_bin, dci_.get_nof_bits()+1, c,dci_.get_nof_bits());
-
-      if (!update_RNTI_list(dci_.get_rnti())) {
-        SPDLOG_ERROR("Failed to update RNTI list");
-      }
-      // Copy DCI message
-      std::vector<uint8_t> dci_payload(c, c + dci_.get_nof_bits());
-      dci_.set_payload(dci_payload);
-      std::string dci_string = dci_msg_bin;
-
-      float sample_time = ((float) metadata )/sample_rate_time;
-      SPDLOG_INFO("Found DCI PDCCH DCI: RNTI = {}, AL = {}, DCI size {}, Time = {}, Samples from start = {}, Slots from samples from start = {} Slot within frame = {}, Symbol within slot = {}, binary dci is {}, correlation is {}",
-      dci_.get_rnti(), dci_.get_found_aggregation_level(), dci_.get_nof_bits(), sample_time + symbol_in_chunk* 0.001, sample_time, symbol_in_chunk, symbol.slot_index, symbol.symbol_index, dci_string, dci_.get_correlation());
-      
-      
-      // MHZ - Track RNTI decoded over time, saving details
-      if (config.rnti_tracker.enabled) {
-        RntiEvent ev{};
-        ev.rnti = dci_.get_rnti();
-        ev.cell_id = coreset_info.get_cell_id();
-        ev.scrambling_id = dci_.get_pdcch_scrambling_id();
-        ev.coreset_id = dci_.get_coreset_id();
-        ev.aggregation_level = dci_.get_found_aggregation_level();
-        ev.candidate_idx = dci_.get_found_candidate();
-        ev.slot = dci_.get_n_slot();
-        ev.ofdm_symbol = symbol.symbol_index;
-        ev.num_symbols_per_slot = 0; // dci_.get_num_symbols_per_slot(ev.slot); // TO FIX
-        ev.correlation = dci_.get_correlation();
-        ev.sample_index = metadata;
-        ev.t_seconds = static_cast<double>(metadata) / static_cast<double>(sample_rate_time);
-
-        RntiTracker::instance().observe(ev);
-      }
-    }
-    srsran_pdcch_nr_free(&q);
-    return res->crc;
+    return checksum1 ^ checksum2;
   }
 
+  /**
+  * Hands a decoded DCI to the event pipeline, which prints, logs and tracks it
+  * off the decode path.
+  */
+  void pdcch::report_dci(symbol& symbol, dci& dci_, uint8_t* c, int64_t metadata, int symbol_in_chunk) {
+    dci_record record;
+    record.rnti = dci_.get_rnti();
+    record.cell_id = coreset_info.get_cell_id();
+    record.scrambling_id = dci_.get_pdcch_scrambling_id();
+    record.coreset_id = dci_.get_coreset_id();
+    record.aggregation_level = dci_.get_found_aggregation_level();
+    record.candidate_idx = dci_.get_found_candidate();
+    record.slot = symbol.slot_index;
+    record.ofdm_symbol = symbol.symbol_index;
+    record.symbol_in_chunk = symbol_in_chunk;
+    record.correlation = dci_.get_correlation();
+    record.sample_index = metadata;
+    record.sample_rate = sample_rate_time;
+    record.pack_payload(c, dci_.get_nof_bits());
+
+    dci_event_pipeline::instance().publish(record);
+  }
 
-  float pdcch::compute_correlation_DMRS(symbol& symbol, std::vector<std::complex<float>>& pdcch_dmrs_symbols, std::vector<uint64_t>& pdcch_dmrs_sc_indices) {
 
-    std::vector<float> correlation_outputs;
-    vector<complex<float>> pdcch_rx_symbols(symbol.samples.size(),0);
+  float pdcch::compute_correlation_DMRS(symbol& symbol, std::span<std::complex<float>> pdcch_dmrs_symbols, std::span<uint64_t> pdcch_dmrs_sc_indices) {
     std::vector<std::complex<float>> rx_dmrs_symbols(pdcch_dmrs_sc_indices.size());
-
-    pdcch_rx_symbols = symbol.samples;
-
     for (size_t i = 0; i < pdcch_dmrs_sc_indices.size(); i++ ) {
-      rx_dmrs_symbols.at(i) = pdcch_rx_symbols.at(pdcch_dmrs_sc_indices.at(i));
+      rx_dmrs_symbols[i] = symbol.samples.at(pdcch_dmrs_sc_indices[i]);
     }
 
-      std::vector<float> correlation_output(1);
+    std::vector<float> correlation_output(1);
+    correlate_magnitude_normalized(correlation_output, rx_dmrs_symbols, pdcch_dmrs_symbols);
+    return correlation_output.at(0);
+  }
 
-      // MHZ - Fixed? "Too many arguments to function call"
-      // correlate_magnitude_normalized(correlation_output, rx_dmrs_symbols, {pdcch_dmrs_symbols.data(), pdcch_dmrs_symbols.size()});
-      correlate_magnitude_normalized(correlation_output, rx_dmrs_symbols, pdcch_dmrs_symbols);
+  /**
+  * Gathers the received DMRS REs of every candidate in the layout of the DMRS
+  * references of the slot, which is the same for all scrambling IDs.
+  */
+  void pdcch::gather_dmrs_batch(symbol& symbol, const pdcch_dmrs_references& layout, dmrs_correlation_batch& batch) {
+    batch.rx_dmrs.assign(layout.symbols.size(), 0);
+
+    for (int agg_level = 0; agg_level < NUM_ALs; agg_level++) {
+      for (int candidate_idx = 0; candidate_idx < layout.max_candidates; candidate_idx++) {
+        size_t i = agg_level * layout.max_candidates + candidate_idx;
+        uint32_t length = layout.offsets[i+1] - layout.offsets[i];
+        std::span<uint64_t> pdcch_dmrs_sc_indices = dmrs_table.dmrs_sc_indices(symbol.slot_index, agg_level, candidate_idx);
+        if (length == 0 || pdcch_dmrs_sc_indices.size() < length) {
+          continue;
+        }
 
-      return correlation_output.at(0);
+        std::complex<float>* rx = batch.rx_dmrs.data() + layout.offsets[i];
+        for (uint32_t j = 0; j < length; j++) {
+          rx[j] = symbol.samples.at(pdcch_dmrs_sc_indices[j]);
+        }
+      }
+    }
+    // Skipped candidates are left zeroed, so their norm is 0
+    segment_norms(batch.rx_norms, batch.rx_dmrs, layout.offsets);
   }
 
+  /**
+  * Correlates the candidates from the largest AL down. Candidates whose DMRS
+  * energy is well below the CORESET average are not correlated, and are left
+  * with a correlation of 0. Candidates contained in a candidate that already
+  * cleared its threshold are deferred: a real DCI of half the AL still gives
+  * its parent a correlation of about 0.7, so they are only settled once the
+  * parent is decoded, and correlated by correlate_deferred() otherwise.
+  *
+  * @return number of correlated candidates
+  */
+  int pdcch::search_candidates_hierarchically(uint8_t slot_index, const pdcch_dmrs_references& references, dmrs_correlation_batch& batch) {
+    size_t num_segments = references.offsets.size() - 1;
+    batch.correlations.assign(num_segments, 0);
 
-  bool pdcch::correlate_DMRS(symbol& symbol, std::vector<dci>& found_dci_list) {
+    float total_energy = 0;
+    for (float norm : batch.rx_norms) {
+      total_energy += norm * norm;
+    }
+    float mean_energy = references.offsets.back() > 0 ? total_energy / references.offsets.back() : 0;
+
+    int num_correlated = 0;
+    for (int agg_level = NUM_ALs - 1; agg_level >= 0; agg_level--) {
+      for (int candidate_idx = 0; candidate_idx < references.max_candidates; candidate_idx++) {
+        size_t i = agg_level * references.max_candidates + candidate_idx;
+        uint32_t length = references.offsets[i+1] - references.offsets[i];
+        if (length == 0 || batch.rx_norms[i] * batch.rx_norms[i] < hierarchical_energy_ratio * mean_energy * length) {
+          continue;
+        }
 
-    dmrs dmrs_pdcch;  
+        bool pruned = false;
+        for (uint16_t parent : dmrs_table.parents(slot_index, agg_level, candidate_idx)) {
+          if (batch.correlations[parent] > AL_corr_thresholds.at(parent / references.max_candidates)) {
+            pruned = true;
+            break;
+          }
+        }
+        if (pruned) {
+          batch.correlations[i] = deferred_correlation;
+          continue;
+        }
 
-    int num_candidate = 0;
-    int max_num_candidate = (coreset_info.get_frequency_domain_resources()*coreset_info.get_duration())/6;
-    bool user_search_space = false;
+        correlate_segments_normalized(batch.segment_correlation, batch.rx_dmrs, references.symbols, std::span<const uint32_t>(references.offsets).subspan(i, 2),
+                                      std::span<const float>(batch.rx_norms).subspan(i, 1), std::span<const float>(references.norms).subspan(i, 1));
+        batch.correlations[i] = batch.segment_correlation.at(0);
+        num_correlated++;
+      }
+    }
+    return num_correlated;
+  }
+
+
+  bool pdcch::correlate_DMRS(symbol& symbol, std::vector<dci>& found_dci_list) {
+    int max_num_candidate = 0;
     bool dci_found = false;
 
-    std::vector<float> correlation_value_per_candidate(max_num_candidate);
-    std::vector<float> correlation_value_per_AL(NUM_ALs);
-    std::vector<int> correlation_index_per_AL(NUM_ALs);
-    std::vector<float> threshold_per_AL = AL_corr_thresholds;
+    // Try to solve for the scrambling ID first, and only scan the whole range if that fails
+    uint32_t first_scrambling_id = scrambling_id_start;
+    uint32_t last_scrambling_id = scrambling_id_end;
+    uint16_t solved_scrambling_id = 0;
+    if (use_scrambling_id_solver && scrambling_id_start != scrambling_id_end && solve_scrambling_id(symbol, solved_scrambling_id)) {
+      first_scrambling_id = solved_scrambling_id;
+      last_scrambling_id = solved_scrambling_id;
+    }
 
+    // Otherwise, outside of full scans, only the scrambling IDs found during discovery are correlated
+    // They are copied, as other flows may record new ones meanwhile
+    std::vector<uint16_t> discovered_scrambling_ids;
+    if (first_scrambling_id != last_scrambling_id) {
+      std::lock_guard<std::mutex> lock(discovery_mutex);
+      if (discovery.restricts_scrambling_ids()) {
+        discovered_scrambling_ids = discovery.get_scrambling_ids();
+      }
+    }
+    size_t num_scrambling_ids = discovered_scrambling_ids.empty() ? last_scrambling_id - first_scrambling_id + 1 : discovered_scrambling_ids.size();
 
-    std::vector<std::complex<float>> pdcch_dmrs_symbols;
-    std::vector<uint64_t> pdcch_dmrs_sc_indices;
+    // Generate the references of the next slot while this one is correlated. The few discovered IDs stay cached.
+    if (dmrs_prefetch && dmrs_table.get_num_slots() > 0 && discovered_scrambling_ids.empty()) {
+      dmrs_cache->prefetch(first_scrambling_id, last_scrambling_id, (symbol.slot_index + 1) % dmrs_table.get_num_slots());
+    }
 
     /* Compute correlation for all possible scrambling IDs*/
-    for (uint32_t pdcch_scrambling_id = scrambling_id_start; pdcch_scrambling_id <= scrambling_id_end; pdcch_scrambling_id++) {
+    dmrs_correlation_batch& batch = correlation_batch;
+    bool bypass_cache = false;
+    for (size_t id_idx = 0; id_idx < num_scrambling_ids; id_idx++) {
+      uint16_t pdcch_scrambling_id = discovered_scrambling_ids.empty() ? first_scrambling_id + id_idx : discovered_scrambling_ids[id_idx];
+      std::shared_ptr<const pdcch_dmrs_references> references = bypass_cache ? dmrs_cache->get_uncached(pdcch_scrambling_id, symbol.slot_index) : dmrs_cache->get(pdcch_scrambling_id, symbol.slot_index);
+      // The received DMRS are gathered once per symbol, then correlated against each scrambling ID in one pass
+      if (id_idx == 0) {
+        gather_dmrs_batch(symbol, *references, batch);
+        // A scan that does not fit in the cache would only evict entries before their reuse
+        bypass_cache = num_scrambling_ids * references->memory_usage() > dmrs_cache->get_capacity_bytes();
+      }
+      if (hierarchical_search) {
+        int num_correlated = search_candidates_hierarchically(symbol.slot_index, *references, batch);
+        SPDLOG_TRACE("Correlated {} of {} candidates at scrambling ID {}", num_correlated, references->norms.size(), pdcch_scrambling_id);
+      } else {
+        correlate_segments_normalized(batch.correlations, batch.rx_dmrs, references->symbols, references->offsets, batch.rx_norms, references->norms);
+      }
+
       /* For all possible Aggregation levels*/
       for (int agg_level = 0; agg_level < NUM_ALs; agg_level++) {
       /* For all possible candidates*/
         max_num_candidate = coreset_info.get_candidates_search_space().at(agg_level);
         for (int candidate_idx = 0; candidate_idx < max_num_candidate; candidate_idx++) {
-          std::string key = std::to_string(pdcch_scrambling_id) + std::to_string(agg_level) + std::to_string(symbol.slot_index) + std::to_string(candidate_idx);
-          pdcch_dmrs_sc_indices = dmrs_sc_indices_table[key];
-          pdcch_dmrs_symbols = dmrs_seq_table[key];
-
-          correlation_value_per_candidate.at(candidate_idx) = compute_correlation_DMRS(symbol, pdcch_dmrs_symbols, pdcch_dmrs_sc_indices);
-          if ((agg_level == 0 && correlation_value_per_candidate.at(candidate_idx) > threshold_per_AL.at(0)) | (agg_level == 1 && correlation_value_per_candidate.at(candidate_idx) > threshold_per_AL.at(1)) | 
-            (agg_level == 2  && correlation_value_per_candidate.at(candidate_idx) > threshold_per_AL.at(2)) | (agg_level == 3  && correlation_value_per_candidate.at(candidate_idx) > threshold_per_AL.at(3)) |
-            (agg_level == 4  && correlation_value_per_candidate.at(candidate_idx) > threshold_per_AL.at(4))) {
-            SPDLOG_DEBUG("Possible DCI with correlation {} at scrambling ID {} and aggregation level AL {} at Cand. Index {} in slot {}", correlation_value_per_candidate.at(candidate_idx),pdcch_scrambling_id, 1<<agg_level, candidate_idx, symbol.slot_index);
+          float correlation = batch.correlations.at(agg_level * references->max_candidates + candidate_idx);
+          if (correlation > AL_corr_thresholds.at(agg_level) || correlation == deferred_correlation) {
+            SPDLOG_DEBUG("Possible DCI with correlation {} at scrambling ID {} and aggregation level AL {} at Cand. Index {} in slot {}", correlation, pdcch_scrambling_id, 1<<agg_level, candidate_idx, symbol.slot_index);
             // We save the possible DCI to decode it in the next step.
-            dci dci_info(true, 1<<agg_level, candidate_idx, max_num_candidate, 0, 0, "ue-rnti", "dci-unknown", 0, {}, 0, pdcch_scrambling_id, symbol.slot_index, symbol.symbol_index, correlation_value_per_candidate.at(candidate_idx));
+            dci dci_info(true, 1<<agg_level, candidate_idx, max_num_candidate, 0, 0, "ue-rnti", "dci-unknown", 0, {}, 0, pdcch_scrambling_id, symbol.slot_index, symbol.symbol_index, correlation);
             found_dci_list.push_back(dci_info);
             dci_found = true;
           }
-
-        } 
+        }
       }
     }
     return dci_found;
   }
 
 
+  /**
+  * Correlates the candidates deferred by the hierarchical search, and removes
+  * those below the threshold of their AL.
+  */
+  void pdcch::correlate_deferred(symbol& symbol, std::vector<dci>& dcis) {
+    auto it = dcis.begin();
+    while (it != dcis.end()) {
+      if (it->get_correlation() != deferred_correlation) {
+        it++;
+        continue;
+      }
+      uint8_t agg_level = (uint8_t)log2(it->get_found_aggregation_level());
+      std::shared_ptr<const pdcch_dmrs_references> references = dmrs_cache->get(it->get_pdcch_scrambling_id(), it->get_n_slot());
+      std::span<uint64_t> dmrs_sc = dmrs_table.dmrs_sc_indices(it->get_n_slot(), agg_level, it->get_found_candidate());
+      std::span<std::complex<float>> dmrs_symbols = references->get(agg_level, it->get_found_candidate());
+      float correlation = compute_correlation_DMRS(symbol, dmrs_symbols, dmrs_sc);
+      if (correlation > AL_corr_thresholds.at(agg_level)) {
+        it->set_correlation(correlation);
+        it++;
+      } else {
+        it = dcis.erase(it);
+      }
+    }
+  }
+
+
   /*Function that returns the interleaver function based on the CORESET configuration, i.e. BundleSize, Duration, BW...
   I am not using the duration because basically you just repeat everything per symbol, the only thing that changes is the c_init of the DMRS*/
   std::vector<uint16_t> pdcch::cce_reg_interleaving() {
@@ -0,0 +1,60 @@
+#include "pdcch_decoder_pool.h"
+#include "exceptions.h"
+#include <spdlog/spdlog.h>
+
+namespace nr {
+  /**
+  * Constructor for pdcch_decoder_context. Allocates the srsRAN PDCCH receiver
+  * buffers and fetches the polar code for the given sizes.
+  *
+  * @param K payload size including CRC
+  * @param E number of rate-matched bits
+  */
+  pdcch_decoder_context::pdcch_decoder_context(uint32_t K, uint32_t E) {
+    q = {};
+
+    srsran_pdcch_nr_args_t args = {};
+    args.disable_simd           = false;
+    args.measure_evm            = false;
+    args.measure_time           = false;
+
+    if (srsran_pdcch_nr_init_rx(&q, &args) < SRSRAN_SUCCESS) {
+      throw sniffer_exception("Error initializing PDCCH decoder context");
+    }
+
+    q.K = K;
+    q.E = E;
+    q.M = E / 2;
+
+    if (srsran_polar_code_get(&q.code, q.K, q.E, 9U) < SRSRAN_SUCCESS) {
+      srsran_pdcch_nr_free(&q);
+      throw sniffer_exception("Error getting polar code for PDCCH decoder context");
+    }
+
+    llr_scratch.resize(E);
+    SPDLOG_DEBUG("Created PDCCH decoder context K={} E={}", K, E);
+  }
+
+  /**
+  * Destructor for pdcch_decoder_context.
+  */
+  pdcch_decoder_context::~pdcch_decoder_context() {
+    srsran_pdcch_nr_free(&q);
+  }
+
+  /**
+  * Returns the decoding context for (K, E), creating it on first use.
+  */
+  pdcch_decoder_context& pdcch_decoder_pool::get(uint32_t K, uint32_t E) {
+    uint64_t key = (static_cast<uint64_t>(K) << 32) | E;
+    auto it = contexts.find(key);
+    if (it == contexts.end()) {
+      it = contexts.emplace(key, std::make_unique<pdcch_decoder_context>(K, E)).first;
+    }
+    return *it->second;
+  }
+
+  size_t pdcch_decoder_pool::size() const {
+    return contexts.size();
+  }
+}
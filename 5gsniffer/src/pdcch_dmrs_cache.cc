@@ -0,0 +1,140 @@
+#include "pdcch_dmrs_cache.h"
+#include <spdlog/spdlog.h>
+
+namespace nr {
+  std::span<std::complex<float>> pdcch_dmrs_references::get(uint8_t agg_level, uint8_t candidate_idx) const {
+    size_t i = static_cast<size_t>(agg_level) * max_candidates + candidate_idx;
+    if (candidate_idx >= max_candidates || i + 1 >= offsets.size()) {
+      return {};
+    }
+    // The references are immutable once cached, the span is non-const to fit the dsp interfaces
+    auto* data = const_cast<std::complex<float>*>(symbols.data());
+    return {data + offsets[i], offsets[i+1] - offsets[i]};
+  }
+
+  size_t pdcch_dmrs_references::memory_usage() const {
+    return sizeof(pdcch_dmrs_references) + symbols.capacity() * sizeof(std::complex<float>) + offsets.capacity() * sizeof(uint32_t) + norms.capacity() * sizeof(float);
+  }
+
+  /**
+  * Constructor for pdcch_dmrs_cache.
+  *
+  * @param generate function generating the references of a (scrambling ID, slot)
+  * @param capacity_bytes memory cap of the cached references
+  */
+  pdcch_dmrs_cache::pdcch_dmrs_cache(generator generate_, size_t capacity_bytes_) :
+    generate(generate_),
+    capacity_bytes(capacity_bytes_) {
+    prefetch_thread = std::thread(&pdcch_dmrs_cache::prefetch_loop, this);
+  }
+
+  /**
+  * Destructor for pdcch_dmrs_cache. Stops the prefetch thread.
+  */
+  pdcch_dmrs_cache::~pdcch_dmrs_cache() {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      stop = true;
+    }
+    prefetch_cv.notify_all();
+    prefetch_thread.join();
+  }
+
+  std::shared_ptr<const pdcch_dmrs_references> pdcch_dmrs_cache::get(uint16_t scrambling_id, uint8_t slot_index) {
+    uint32_t k = key(scrambling_id, slot_index);
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      auto it = entries.find(k);
+      if (it != entries.end()) {
+        lru.splice(lru.begin(), lru, it->second.lru_position);
+        return it->second.references;
+      }
+    }
+
+    // Generate outside of the lock so other threads are not blocked
+    return insert(k, generate(scrambling_id, slot_index));
+  }
+
+  std::shared_ptr<const pdcch_dmrs_references> pdcch_dmrs_cache::get_uncached(uint16_t scrambling_id, uint8_t slot_index) {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      auto it = entries.find(key(scrambling_id, slot_index));
+      if (it != entries.end()) {
+        return it->second.references;
+      }
+    }
+    return generate(scrambling_id, slot_index);
+  }
+
+  std::shared_ptr<const pdcch_dmrs_references> pdcch_dmrs_cache::insert(uint32_t k, std::shared_ptr<const pdcch_dmrs_references> references) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = entries.find(k);
+    if (it != entries.end()) {
+      // Generated concurrently by another thread
+      lru.splice(lru.begin(), lru, it->second.lru_position);
+      return it->second.references;
+    }
+
+    lru.push_front(k);
+    entries.emplace(k, entry{references, lru.begin()});
+    used_bytes += references->memory_usage();
+
+    while (used_bytes > capacity_bytes && lru.size() > 1) {
+      auto evicted = entries.find(lru.back());
+      used_bytes -= evicted->second.references->memory_usage();
+      entries.erase(evicted);
+      lru.pop_back();
+    }
+    return references;
+  }
+
+  void pdcch_dmrs_cache::prefetch(uint16_t first_scrambling_id, uint16_t last_scrambling_id, uint8_t slot_index) {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      pending_prefetch = prefetch_request{first_scrambling_id, last_scrambling_id, slot_index};
+    }
+    prefetch_cv.notify_one();
+  }
+
+  void pdcch_dmrs_cache::prefetch_loop() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+      prefetch_cv.wait(lock, [this] { return stop || pending_prefetch.has_value(); });
+      if (stop) {
+        return;
+      }
+      prefetch_request request = *pending_prefetch;
+      pending_prefetch.reset();
+
+      size_t prefetched = 0;
+      size_t prefetched_bytes = 0;
+      for (uint32_t scrambling_id = request.first_scrambling_id; scrambling_id <= request.last_scrambling_id; scrambling_id++) {
+        // Newer requests take over, and never evict what this request just generated
+        if (stop || pending_prefetch.has_value() || prefetched_bytes >= capacity_bytes / 2) {
+          break;
+        }
+        uint32_t k = key(scrambling_id, request.slot_index);
+        if (entries.count(k)) {
+          continue;
+        }
+        lock.unlock();
+        std::shared_ptr<const pdcch_dmrs_references> references = generate(scrambling_id, request.slot_index);
+        prefetched_bytes += references->memory_usage();
+        insert(k, references);
+        prefetched++;
+        lock.lock();
+      }
+      SPDLOG_DEBUG("Prefetched {} DMRS references for slot {}", prefetched, request.slot_index);
+    }
+  }
+
+  size_t pdcch_dmrs_cache::size() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return entries.size();
+  }
+
+  size_t pdcch_dmrs_cache::memory_usage() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return used_bytes;
+  }
+}
@@ -0,0 +1,102 @@
+#include "pdcch_dmrs_table.h"
+#include <algorithm>
+
+namespace nr {
+  void pdcch_dmrs_table::reset(uint8_t num_slots_, const std::vector<uint8_t>& candidates_per_AL) {
+    num_slots = num_slots_;
+    max_candidates = candidates_per_AL.empty() ? 0 : *std::max_element(candidates_per_AL.begin(), candidates_per_AL.end());
+
+    entries.assign(static_cast<size_t>(num_slots) * NUM_ALs * max_candidates, entry{});
+    dmrs_sc_slab.clear();
+    data_sc_slab.clear();
+    dmrs_rb_slab.clear();
+    parents_slab.clear();
+  }
+
+  void pdcch_dmrs_table::add(uint8_t slot_index, uint8_t agg_level, uint8_t candidate_idx, const std::vector<uint64_t>& dmrs_sc_indices, const std::vector<uint16_t>& data_sc_indices, const std::vector<uint16_t>& dmrs_rb_indices) {
+    if (slot_index >= num_slots || agg_level >= NUM_ALs || candidate_idx >= max_candidates) {
+      return;
+    }
+
+    entry& e = entries.at((static_cast<size_t>(slot_index) * NUM_ALs + agg_level) * max_candidates + candidate_idx);
+    e.valid = true;
+    e.dmrs_sc_offset = dmrs_sc_slab.size();
+    e.dmrs_sc_length = dmrs_sc_indices.size();
+    e.data_sc_offset = data_sc_slab.size();
+    e.data_sc_length = data_sc_indices.size();
+    e.dmrs_rb_offset = dmrs_rb_slab.size();
+    e.dmrs_rb_length = dmrs_rb_indices.size();
+
+    dmrs_sc_slab.insert(dmrs_sc_slab.end(), dmrs_sc_indices.begin(), dmrs_sc_indices.end());
+    data_sc_slab.insert(data_sc_slab.end(), data_sc_indices.begin(), data_sc_indices.end());
+    dmrs_rb_slab.insert(dmrs_rb_slab.end(), dmrs_rb_indices.begin(), dmrs_rb_indices.end());
+  }
+
+  const pdcch_dmrs_table::entry* pdcch_dmrs_table::find(uint8_t slot_index, uint8_t agg_level, uint8_t candidate_idx) const {
+    if (slot_index >= num_slots || agg_level >= NUM_ALs || candidate_idx >= max_candidates) {
+      return nullptr;
+    }
+    const entry& e = entries[(static_cast<size_t>(slot_index) * NUM_ALs + agg_level) * max_candidates + candidate_idx];
+    return e.valid ? &e : nullptr;
+  }
+
+  void pdcch_dmrs_table::link_parents() {
+    parents_slab.clear();
+    std::vector<std::vector<uint64_t>> sorted_sc(NUM_ALs * max_candidates);
+
+    for (uint8_t slot_index = 0; slot_index < num_slots; slot_index++) {
+      for (uint8_t agg_level = 0; agg_level < NUM_ALs; agg_level++) {
+        for (uint8_t candidate_idx = 0; candidate_idx < max_candidates; candidate_idx++) {
+          std::span<uint64_t> sc = dmrs_sc_indices(slot_index, agg_level, candidate_idx);
+          std::vector<uint64_t>& sorted = sorted_sc[agg_level * max_candidates + candidate_idx];
+          sorted.assign(sc.begin(), sc.end());
+          std::sort(sorted.begin(), sorted.end());
+        }
+      }
+
+      for (uint8_t agg_level = 0; agg_level < NUM_ALs; agg_level++) {
+        for (uint8_t candidate_idx = 0; candidate_idx < max_candidates; candidate_idx++) {
+          entry& e = entries[(static_cast<size_t>(slot_index) * NUM_ALs + agg_level) * max_candidates + candidate_idx];
+          if (!e.valid) {
+            continue;
+          }
+          const std::vector<uint64_t>& child = sorted_sc[agg_level * max_candidates + candidate_idx];
+          e.parents_offset = parents_slab.size();
+          for (uint8_t parent_level = agg_level + 1; parent_level < NUM_ALs; parent_level++) {
+            for (uint8_t parent_idx = 0; parent_idx < max_candidates; parent_idx++) {
+              const std::vector<uint64_t>& parent = sorted_sc[parent_level * max_candidates + parent_idx];
+              if (!parent.empty() && std::includes(parent.begin(), parent.end(), child.begin(), child.end())) {
+                parents_slab.push_back(parent_level * max_candidates + parent_idx);
+              }
+            }
+          }
+          e.parents_length = parents_slab.size() - e.parents_offset;
+        }
+      }
+    }
+  }
+
+  bool pdcch_dmrs_table::contains(uint8_t slot_index, uint8_t agg_level, uint8_t candidate_idx) const {
+    return find(slot_index, agg_level, candidate_idx) != nullptr;
+  }
+
+  std::span<uint64_t> pdcch_dmrs_table::dmrs_sc_indices(uint8_t slot_index, uint8_t agg_level, uint8_t candidate_idx) {
+    const entry* e = find(slot_index, agg_level, candidate_idx);
+    return e ? std::span<uint64_t>(dmrs_sc_slab.data() + e->dmrs_sc_offset, e->dmrs_sc_length) : std::span<uint64_t>();
+  }
+
+  std::span<uint16_t> pdcch_dmrs_table::data_sc_indices(uint8_t slot_index, uint8_t agg_level, uint8_t candidate_idx) {
+    const entry* e = find(slot_index, agg_level, candidate_idx);
+    return e ? std::span<uint16_t>(data_sc_slab.data() + e->data_sc_offset, e->data_sc_length) : std::span<uint16_t>();
+  }
+
+  std::span<uint16_t> pdcch_dmrs_table::dmrs_rb_indices(uint8_t slot_index, uint8_t agg_level, uint8_t candidate_idx) {
+    const entry* e = find(slot_index, agg_level, candidate_idx);
+    return e ? std::span<uint16_t>(dmrs_rb_slab.data() + e->dmrs_rb_offset, e->dmrs_rb_length) : std::span<uint16_t>();
+  }
+
+  std::span<const uint16_t> pdcch_dmrs_table::parents(uint8_t slot_index, uint8_t agg_level, uint8_t candidate_idx) const {
+    const entry* e = find(slot_index, agg_level, candidate_idx);
+    return e ? std::span<const uint16_t>(parents_slab.data() + e->parents_offset, e->parents_length) : std::span<const uint16_t>();
+  }
+}
@@ -1,4 +1,5 @@
 #include "pss.h"
+#include "fft_plan.h"
 
 /* Default Constructor */
 pss::pss(){
@@ -122,18 +123,12 @@ std::array <std::complex<float>,ssb_nfft>  pss::convert_pss_t(std::array <std::c
   /*Perform ifft shift before the transform*/
   std::rotate(pss_seq_f_padded.begin(), pss_seq_f_padded.begin() + 128, pss_seq_f_padded.end());
   
-  auto p_time = reinterpret_cast<liquid_float_complex*>(pss_seq_t.data());
-  auto p_freq = reinterpret_cast<liquid_float_complex*>(pss_seq_f_padded.data());
-  
-  /*Create liquid FFT plan*/
-  int flags = 0;
-  fftplan q = fft_create_plan(pss_seq_f_padded.size(), p_freq, p_time, LIQUID_FFT_BACKWARD, flags);
+  nr::fft_plan& ifft = nr::fft_plan::get(pss_seq_f_padded.size(), false);
+  std::copy(pss_seq_f_padded.begin(), pss_seq_f_padded.end(), ifft.input().begin());
 
   /*execute IFFT*/ 
-  fft_execute(q);
-
-  /*destroy FFT plan*/
-  fft_destroy_plan(q);
+  ifft.execute();
+  std::copy(ifft.output().begin(), ifft.output().end(), pss_seq_t.begin());
 
   return pss_seq_t;
 }
@@ -0,0 +1,104 @@
+#include "rnti_recency.h"
+#include <algorithm>
+#include <bit>
+#include <functional>
+
+namespace nr {
+  rnti_recency::rnti_recency() :
+    stamps(num_rntis),
+    touched(num_rntis / 64),
+    members(num_rntis, 0),
+    is_promoted(num_rntis, 0),
+    current(std::make_shared<const std::vector<uint16_t>>()) {
+  }
+
+  void rnti_recency::reset(const std::vector<uint16_t>& initial_order_) {
+    std::lock_guard<std::mutex> lock(publish_mutex);
+    initial_order = initial_order_;
+    std::fill(members.begin(), members.end(), 0);
+    for (uint16_t rnti : initial_order) {
+      members[rnti] = 1;
+    }
+    for (auto& stamp : stamps) {
+      stamp.store(0, std::memory_order_relaxed);
+    }
+    for (auto& word : touched) {
+      word.store(0, std::memory_order_relaxed);
+    }
+    sequence = 0;
+    promoted.clear();
+    std::fill(is_promoted.begin(), is_promoted.end(), 0);
+    current.store(std::make_shared<const std::vector<uint16_t>>(initial_order), std::memory_order_release);
+  }
+
+  bool rnti_recency::promote(uint16_t rnti, uint32_t epoch) {
+    if (!members[rnti]) {
+      return false;
+    }
+    uint64_t stamp = (static_cast<uint64_t>(epoch) << 32) | ++sequence;
+    stamps[rnti].store(stamp, std::memory_order_relaxed);
+    touched[rnti / 64].fetch_or(uint64_t(1) << (rnti % 64), std::memory_order_release);
+    return true;
+  }
+
+  bool rnti_recency::is_aged(uint64_t stamp, uint32_t epoch) const {
+    uint32_t stamp_epoch = stamp >> 32;
+    return max_age > 0 && epoch > stamp_epoch && epoch - stamp_epoch > max_age;
+  }
+
+  void rnti_recency::publish(uint32_t epoch) {
+    std::lock_guard<std::mutex> lock(publish_mutex);
+
+    // Collect the RNTIs promoted since the last snapshot
+    bool changed = false;
+    for (size_t word = 0; word < touched.size(); word++) {
+      uint64_t bits = touched[word].exchange(0, std::memory_order_acquire);
+      while (bits) {
+        int bit = std::countr_zero(bits);
+        bits &= bits - 1;
+        uint16_t rnti = word * 64 + bit;
+        if (!is_promoted[rnti]) {
+          is_promoted[rnti] = 1;
+          promoted.push_back(rnti);
+        }
+        changed = true;
+      }
+    }
+
+    // Drop the RNTIs that aged out
+    size_t num_promoted = promoted.size();
+    promoted.erase(std::remove_if(promoted.begin(), promoted.end(), [&](uint16_t rnti) {
+      bool aged = is_aged(stamps[rnti].load(std::memory_order_relaxed), epoch);
+      if (aged) {
+        is_promoted[rnti] = 0;
+      }
+      return aged;
+    }), promoted.end());
+    changed |= promoted.size() != num_promoted;
+
+    if (!changed) {
+      return;
+    }
+
+    // Stamps can change while sorting, so sort on a copy
+    std::vector<std::pair<uint64_t, uint16_t>> by_stamp;
+    by_stamp.reserve(promoted.size());
+    for (uint16_t rnti : promoted) {
+      by_stamp.emplace_back(stamps[rnti].load(std::memory_order_relaxed), rnti);
+    }
+    std::sort(by_stamp.begin(), by_stamp.end(), std::greater<>());
+    for (size_t i = 0; i < by_stamp.size(); i++) {
+      promoted[i] = by_stamp[i].second;
+    }
+
+    auto order = std::make_shared<std::vector<uint16_t>>();
+    order->reserve(initial_order.size());
+    order->insert(order->end(), promoted.begin(), promoted.end());
+    for (uint16_t rnti : initial_order) {
+      if (!is_promoted[rnti]) {
+        order->push_back(rnti);
+      }
+    }
+    current.store(std::move(order), std::memory_order_release);
+  }
+}
@@ -0,0 +1,26 @@
+#include "sample_view.h"
+#include <cassert>
+
+sample_view::sample_view(shared_ptr<vector<complex<float>>> buffer, size_t offset, size_t length) :
+  buffer(std::move(buffer)),
+  offset(offset),
+  length(length) {
+  assert(this->buffer && offset + length <= this->buffer->size());
+}
+
+sample_view::sample_view(shared_ptr<vector<complex<float>>> buffer) :
+  buffer(std::move(buffer)),
+  offset(0),
+  length(this->buffer->size()) {
+}
+
+sample_view sample_view::zeros(size_t num_samples) {
+  // Replaced rather than grown, so views handed out before stay valid. One
+  // sample longer than any view, so a zero view is never whole and never
+  // handed to a worker as a buffer it could modify.
+  static thread_local shared_ptr<vector<complex<float>>> zero_buffer = make_shared<vector<complex<float>>>(1, complex<float>(0));
+  if (zero_buffer->size() <= num_samples) {
+    zero_buffer = make_shared<vector<complex<float>>>(num_samples + 1, complex<float>(0));
+  }
+  return sample_view(zero_buffer, 0, num_samples);
+}
@@ -0,0 +1,186 @@
+#include "scrambling_id_solver.h"
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <numeric>
+
+namespace nr {
+  // Longest Gold sequence offset handled, covers the DMRS of 275 RBs
+  static constexpr uint32_t max_sequence_length = Nc + 2048;
+  // RBs on each side averaged into the phase estimate of an RB
+  static constexpr int phase_window_rbs = 2;
+
+  /**
+  * x1 bits and the GF(2) masks of x2 bits over the 31 bits of c_init, for
+  * every sequence position, computed once with the recursions of TS 38.211 5.2.1.
+  */
+  struct gold_sequence_tables {
+    std::vector<uint8_t> x1;
+    std::vector<uint32_t> x2;
+
+    gold_sequence_tables() : x1(max_sequence_length + gold_sequence_length, 0), x2(max_sequence_length + gold_sequence_length, 0) {
+      x1.at(0) = 1;
+      for (uint32_t n = 0; n < gold_sequence_length; n++) {
+        x2.at(n) = 1U << n;
+      }
+      for (uint32_t n = 0; n < max_sequence_length; n++) {
+        x1.at(n+31) = x1.at(n+3) ^ x1.at(n);
+        x2.at(n+31) = x2.at(n+3) ^ x2.at(n+2) ^ x2.at(n+1) ^ x2.at(n);
+      }
+    }
+  };
+
+  static const gold_sequence_tables& tables() {
+    static const gold_sequence_tables t;
+    return t;
+  }
+
+  bool scrambling_id_solver::solve_c_init(const std::vector<uint32_t>& positions, const std::vector<uint8_t>& bits, const std::vector<float>& reliability, uint32_t& c_init) {
+    const gold_sequence_tables& t = tables();
+    const size_t num_bits = positions.size();
+    if (num_bits < gold_sequence_length) {
+      return false;
+    }
+
+    std::vector<size_t> order(num_bits);
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) { return reliability.at(a) > reliability.at(b); });
+
+    // Row reduction, basis[p] holds an equation whose highest unknown is p
+    uint32_t basis_mask[gold_sequence_length] = {};
+    uint8_t basis_rhs[gold_sequence_length] = {};
+    uint32_t rank = 0;
+    for (size_t i = 0; i < num_bits && rank < gold_sequence_length; i++) {
+      uint32_t n = positions.at(order.at(i)) + Nc;
+      if (n >= max_sequence_length) {
+        return false;
+      }
+      uint32_t mask = t.x2.at(n);
+      uint8_t rhs = bits.at(order.at(i)) ^ t.x1.at(n);
+      while (mask != 0) {
+        int p = 31 - std::countl_zero(mask);
+        if (basis_mask[p] == 0) {
+          basis_mask[p] = mask;
+          basis_rhs[p] = rhs;
+          rank++;
+          break;
+        }
+        mask ^= basis_mask[p];
+        rhs ^= basis_rhs[p];
+      }
+    }
+    if (rank < gold_sequence_length) {
+      return false;
+    }
+
+    // Substitution from the lowest unknown upwards
+    uint32_t state = 0;
+    for (uint32_t p = 0; p < gold_sequence_length; p++) {
+      uint32_t lower = basis_mask[p] & ~(1U << p);
+      uint32_t bit = basis_rhs[p] ^ (std::popcount(lower & state) & 1);
+      state |= bit << p;
+    }
+
+    // Hard decision errors are tolerated as long as most bits agree
+    size_t mismatches = 0;
+    for (size_t i = 0; i < num_bits; i++) {
+      uint32_t n = positions.at(i) + Nc;
+      uint8_t predicted = (std::popcount(t.x2.at(n) & state) & 1) ^ t.x1.at(n);
+      mismatches += predicted != bits.at(i);
+    }
+    if (10 * mismatches > num_bits) {
+      return false;
+    }
+
+    c_init = state;
+    return true;
+  }
+
+  bool scrambling_id_solver::c_init_to_n_id(uint32_t c_init, uint8_t n_slot, uint8_t n_ofdm, uint8_t num_symbols_per_slot, uint16_t& n_id) {
+    // Only the 31 bits of c_init loaded into x2 are observable
+    const uint32_t mask31 = (1U << gold_sequence_length) - 1;
+    const uint32_t mask30 = mask31 >> 1;
+    const uint32_t A = (static_cast<uint32_t>(num_symbols_per_slot * n_slot + n_ofdm + 1) << 17);
+
+    // c_init = A*(2n+1) + 2n = A + 2n*(A+1), with A+1 odd and so invertible mod 2^30
+    uint32_t d = (c_init - A) & mask31;
+    if (d & 1) {
+      return false;
+    }
+    uint32_t a = A + 1;
+    uint32_t inv = a;
+    for (int i = 0; i < 5; i++) {
+      inv *= 2 - a * inv;
+    }
+    uint32_t n = ((d >> 1) * inv) & mask30;
+    if (n > 0xffff) {
+      return false;
+    }
+
+    if (((A * (2 * n + 1) + 2 * n) & mask31) != (c_init & mask31)) {
+      return false;
+    }
+    n_id = static_cast<uint16_t>(n);
+    return true;
+  }
+
+  bool scrambling_id_solver::solve(const std::vector<std::complex<float>>& rx_dmrs, const std::vector<uint16_t>& seq_indices, uint8_t n_slot, uint8_t n_ofdm, uint8_t num_symbols_per_slot, uint16_t& n_id) {
+    const size_t num_res = rx_dmrs.size();
+    if (num_res == 0 || 2 * num_res < gold_sequence_length) {
+      return false;
+    }
+
+    // Fourth-power phase per RB, QPSK symbols raised to the fourth power are all -1.
+    // Estimates are averaged over neighbouring RBs and the pi/2 ambiguity is
+    // unwrapped RB to RB, so the channel phase stays continuous.
+    std::vector<size_t> rb_start;
+    std::vector<std::complex<float>> rb_z;
+    for (size_t i = 0; i < num_res; i++) {
+      if (i == 0 || seq_indices.at(i) / DMRS_RE_PRB != seq_indices.at(i-1) / DMRS_RE_PRB) {
+        rb_start.push_back(i);
+        rb_z.push_back(0);
+      }
+      std::complex<float> y2 = rx_dmrs.at(i) * rx_dmrs.at(i);
+      rb_z.back() += y2 * y2;
+    }
+    rb_start.push_back(num_res);
+
+    const int num_rbs = rb_z.size();
+    std::vector<float> phase(num_res);
+    float previous = 0;
+    for (int rb = 0; rb < num_rbs; rb++) {
+      std::complex<float> z = 0;
+      for (int k = std::max(0, rb - phase_window_rbs); k <= std::min(num_rbs - 1, rb + phase_window_rbs); k++) {
+        z += rb_z.at(k);
+      }
+      float theta = std::arg(-z) / 4;
+      if (rb > 0) {
+        theta += std::round((previous - theta) / static_cast<float>(M_PI_2)) * static_cast<float>(M_PI_2);
+      }
+      std::fill(phase.begin() + rb_start.at(rb), phase.begin() + rb_start.at(rb+1), theta);
+      previous = theta;
+    }
+
+    std::vector<uint32_t> positions(2 * num_res);
+    std::vector<uint8_t> bits(2 * num_res);
+    std::vector<float> reliability(2 * num_res);
+    for (int rotation = 0; rotation < 4; rotation++) {
+      for (size_t i = 0; i < num_res; i++) {
+        std::complex<float> y = rx_dmrs.at(i) * std::polar(1.0f, -(phase.at(i) + rotation * static_cast<float>(M_PI_2)));
+        // r(m) = (1 - 2c(2m)) + j(1 - 2c(2m+1)), up to a scale
+        positions.at(2*i) = 2 * seq_indices.at(i);
+        bits.at(2*i) = y.real() < 0;
+        reliability.at(2*i) = std::abs(y.real());
+        positions.at(2*i+1) = 2 * seq_indices.at(i) + 1;
+        bits.at(2*i+1) = y.imag() < 0;
+        reliability.at(2*i+1) = std::abs(y.imag());
+      }
+
+      uint32_t c_init = 0;
+      if (solve_c_init(positions, bits, reliability, c_init) && c_init_to_n_id(c_init, n_slot, n_ofdm, num_symbols_per_slot, n_id)) {
+        return true;
+      }
+    }
+    return false;
+  }
+}
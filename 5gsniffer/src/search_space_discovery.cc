@@ -0,0 +1,61 @@
+#include "search_space_discovery.h"
+#include <algorithm>
+#include <spdlog/spdlog.h>
+
+namespace nr {
+  search_space_discovery::search_space_discovery() :
+    rnti_blocks((1 << 16) / rnti_block_size, 0) {
+  }
+
+  void search_space_discovery::configure(uint32_t discovery_ms_, uint32_t rescan_period_ms_, uint32_t rescan_ms_) {
+    discovery_ms = discovery_ms_;
+    rescan_period_ms = rescan_period_ms_;
+    rescan_ms = std::min(rescan_ms_, rescan_period_ms_);
+  }
+
+  void search_space_discovery::update(uint32_t time_ms) {
+    if (discovery_ms == 0) {
+      return;
+    }
+    if (!started) {
+      started = true;
+      start_ms = time_ms;
+    }
+
+    uint32_t elapsed_ms = time_ms - start_ms;
+    bool was_full_scan = full_scan;
+    if (elapsed_ms < discovery_ms) {
+      full_scan = true;
+    } else if (rescan_period_ms > 0) {
+      // Rescans close each period, so the first one comes a period after discovery
+      full_scan = (elapsed_ms - discovery_ms) % rescan_period_ms >= rescan_period_ms - rescan_ms;
+    } else {
+      full_scan = false;
+    }
+
+    if (was_full_scan && !full_scan) {
+      SPDLOG_INFO("[DISCOVERY] t_ms={} searching scrambling_ids={} rnti_blocks={}", elapsed_ms, scrambling_ids.size(), num_rnti_blocks);
+      if (scrambling_ids.empty() || num_rnti_blocks == 0) {
+        SPDLOG_WARN("Discovery found no DCI, the whole scrambling ID or RNTI range is still searched");
+      }
+    } else if (!was_full_scan && full_scan) {
+      SPDLOG_DEBUG("[DISCOVERY] t_ms={} full rescan", elapsed_ms);
+    }
+  }
+
+  void search_space_discovery::record(uint16_t scrambling_id, uint16_t rnti) {
+    auto it = std::lower_bound(scrambling_ids.begin(), scrambling_ids.end(), scrambling_id);
+    if (it == scrambling_ids.end() || *it != scrambling_id) {
+      scrambling_ids.insert(it, scrambling_id);
+      SPDLOG_DEBUG("Discovered scrambling ID {}", scrambling_id);
+    }
+
+    uint8_t& block = rnti_blocks[rnti / rnti_block_size];
+    if (!block) {
+      block = 1;
+      num_rnti_blocks++;
+      rnti_blocks_version++;
+      SPDLOG_DEBUG("Discovered RNTI block {}..{}", rnti / rnti_block_size * rnti_block_size, (rnti / rnti_block_size + 1) * rnti_block_size - 1);
+    }
+  }
+}
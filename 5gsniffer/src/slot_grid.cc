@@ -0,0 +1,30 @@
+#include "slot_grid.h"
+#include <cassert>
+
+void slot_grid::reset(size_t num_subcarriers) {
+  this->num_subcarriers = num_subcarriers;
+  res.clear();
+  symbols.clear();
+}
+
+void slot_grid::reserve(size_t num_symbols) {
+  res.reserve(num_symbols * num_subcarriers);
+  symbols.reserve(num_symbols);
+}
+
+span<complex<float>> slot_grid::add_symbol(const symbol_info& info) {
+  symbols.push_back(info);
+  res.resize(symbols.size() * num_subcarriers);
+  return row(symbols.size() - 1);
+}
+
+symbol slot_grid::to_symbol(size_t i, size_t count) const {
+  assert(i + count <= size());
+  auto samples = rows(i, count);
+  symbol s;
+  s.sample_index = symbols[i].sample_index;
+  s.symbol_index = symbols[i].symbol_index;
+  s.slot_index = symbols[i].slot_index;
+  s.samples.assign(samples.begin(), samples.end());
+  return s;
+}
@@ -6,6 +6,7 @@
 #include "spdlog/spdlog.h"
 #include "phy_params_common.h"
 #include "utils.h"
+#include "cell_manager.h"
 #include <memory>
 
 using namespace std;
@@ -13,6 +14,7 @@ using namespace std;
 // MHZ - Import
 #include "config.h"
 #include "rnti_tracker.hpp"
+#include "dci_event_pipeline.h"
 
 /** 
  * Constructor for sniffer when using SDR.
@@ -51,15 +53,21 @@ sniffer::sniffer(uint64_t sample_rate, string path, uint16_t ssb_numerology, con
  * Common initializer helper function shared amongst constructors.
  */
 void sniffer::init() {
+  // Callbacks
+  device->on_end = std::bind(&sniffer::stop, this);
+
+  // Every cell of the capture gets a syncer of its own
+  if (config.multi_cell) {
+    device->connect(make_shared<nr::cell_manager>(sample_rate, ssb_numerology, this->zmq_address_));
+    return;
+  }
+
   // Create blocks
   auto phy = make_shared<nr::phy>();  
   phy->ssb_bwp = make_unique<bandwidth_part>(3'840'000 * (1<<ssb_numerology), ssb_numerology, ssb_rb); // Default bandwidth part that captures at least 256 subcarriers (240 needed for SSB).
   // MHZ - Pass zmq_address
   auto syncer = make_shared<class syncer>(sample_rate, phy, this->zmq_address_);
 
-  // Callbacks
-  device->on_end = std::bind(&sniffer::stop, this);
-
   device->connect(syncer);
 }
 
@@ -82,6 +90,9 @@ void sniffer::start() {
   } else {
     SPDLOG_INFO("RNTI Tracker disabled via config.");
   }
+
+  // Decoded DCIs are printed, logged and tracked off the flow threads
+  nr::dci_event_pipeline::instance().start();
   
   while(running) {
     // MHZ - This message is called both with file_source and SDR. Correct?
@@ -92,6 +103,8 @@ void sniffer::start() {
     time_profile_end(sniffer_work_t0, "sniffer::work");
   }
 
+  nr::dci_event_pipeline::instance().stop();
+
   SPDLOG_DEBUG("Terminating sniffer");
 }
 
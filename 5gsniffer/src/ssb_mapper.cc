@@ -33,8 +33,6 @@ ssb_mapper::~ssb_mapper() {
 void ssb_mapper::process(shared_ptr<vector<symbol>>& symbols, int64_t metadata) {
   SPDLOG_DEBUG("Got {} symbols", symbols->size());
 
-  auto ssss = phy->ssss;
-
   if(symbols->size() >= 4) {
     if (phy->in_synch){
       // No need to re-find SSS. fine time synch with SSS is performed in syncer.cc.
@@ -48,28 +46,35 @@ void ssb_mapper::process(shared_ptr<vector<symbol>>& symbols, int64_t metadata)
       span<complex<float>> sss_res = symbols->at(2).get_res(56, 182);
       assert(sss_res.size() == sss_length);
       
-      // Find SSS through correlation
+      // Find SSS through one matrix-vector product against the shared references of every NID1 of this NID2, or of every cell
+      thread_local vector<float> correlations;
+      if (joint_nid2) {
+        sss_table::get().correlate_all(correlations, sss_res);
+      } else {
+        sss_table::get().correlate(correlations, sss_res, phy->nid2);
+      }
+
       float max_corr = 0.0f;
-      uint16_t max_nid = 0;
+      size_t max_idx = 0;
       float avg_corr = 0.0f;
-      for(uint16_t nid1 = 0; nid1 <= 335; nid1++) {
-        auto sss_ref = ssss.at(nid1*3 + phy->nid2);
-        vector<float> out(1);
-
-        correlate_magnitude(out, sss_ref, sss_res);
-
-        float corr = out.at(0);
+      for(size_t i = 0; i < correlations.size(); i++) {
+        float corr = correlations[i];
         avg_corr += corr;
         if(corr > max_corr) {
           max_corr = corr;
-          max_nid = nid1;
+          max_idx = i;
         }
       }
-      avg_corr /= 355;
+      avg_corr /= correlations.size();
+      uint16_t max_nid = max_idx % (nid_1_max + 1);
 
       SPDLOG_DEBUG("SSS max corr: {} ({} avg)", max_corr, avg_corr);
 
       if (max_corr > pss_sss_times_avg_threshold * avg_corr) {
+        if (joint_nid2 && phy->nid2 != max_idx / (nid_1_max + 1)) {
+          SPDLOG_DEBUG("SSS overrides PSS NID2 {} with {}", phy->nid2, max_idx / (nid_1_max + 1));
+          phy->nid2 = max_idx / (nid_1_max + 1);
+        }
         SPDLOG_DEBUG("NID1: {}, corr {} avg {} ratio {}", max_nid, max_corr, avg_corr, max_corr / avg_corr);
         this->on_sss_found(max_nid);
 
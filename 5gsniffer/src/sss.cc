@@ -1,4 +1,7 @@
 #include "sss.h"
+#include "dsp.h"
+#include "fft_plan.h"
+#include <cmath>
 
 /* Default Constructor */
 sss::sss(){
@@ -142,21 +145,52 @@ std::array <std::complex<float>,ssb_nfft>  sss::convert_sss_t(std::array <std::c
   /*Perform ifft shift before the transform*/
   std::rotate(sss_seq_f_padded.begin(), sss_seq_f_padded.begin() + 128, sss_seq_f_padded.end());
   
-  auto p_time = reinterpret_cast<liquid_float_complex*>(sss_seq_t.data());
-  auto p_freq = reinterpret_cast<liquid_float_complex*>(sss_seq_f_padded.data());
-  
-  /*Create liquid FFT plan*/
-  int flags = 0;
-  fftplan q = fft_create_plan(sss_seq_f_padded.size(), p_freq, p_time, LIQUID_FFT_BACKWARD, flags);
+  nr::fft_plan& ifft = nr::fft_plan::get(sss_seq_f_padded.size(), false);
+  std::copy(sss_seq_f_padded.begin(), sss_seq_f_padded.end(), ifft.input().begin());
 
   /*execute IFFT*/ 
-  fft_execute(q);
-
-  /*destroy FFT plan*/
-  fft_destroy_plan(q);
+  ifft.execute();
+  std::copy(ifft.output().begin(), ifft.output().end(), sss_seq_t.begin());
 
   return sss_seq_t;
 }
 
 
 
+
+/* The table is built on first use, which is thread-safe for a static local */
+const sss_table& sss_table::get(){
+  static const sss_table table;
+  return table;
+}
+
+sss_table::sss_table() :
+  matrix((nid_max + 1) * sss_length),
+  norms(nid_max + 1) {
+  sss generator;
+  for (uint8_t nid_2 = 0; nid_2 <= nid_2_max; nid_2++){
+    for (uint16_t nid_1 = 0; nid_1 <= nid_1_max; nid_1++){
+      auto sss_seq_f = generator.generate_sss_seq(nid_1, nid_2);
+      size_t row = nid_2 * (nid_1_max + 1) + nid_1;
+      float norm = 0;
+      for (int i = 0; i < sss_length; i++){
+        matrix.at(row * sss_length + i) = sss_seq_f.at(i).real();
+        norm += std::norm(sss_seq_f.at(i));
+      }
+      norms.at(row) = std::sqrt(norm);
+    }
+  }
+}
+
+std::span<const float> sss_table::get_sss_seq(uint16_t nid_1, uint8_t nid_2) const{
+  return std::span<const float>(matrix).subspan((nid_2 * (nid_1_max + 1) + nid_1) * sss_length, sss_length);
+}
+
+void sss_table::correlate(std::vector<float>& correlations, std::span<const std::complex<float>> sss_res, uint8_t nid_2) const{
+  size_t rows = nid_1_max + 1;
+  correlate_magnitude_normalized_rows(correlations, sss_res, std::span<const float>(matrix).subspan(nid_2 * rows * sss_length, rows * sss_length), std::span<const float>(norms).subspan(nid_2 * rows, rows));
+}
+
+void sss_table::correlate_all(std::vector<float>& correlations, std::span<const std::complex<float>> sss_res) const{
+  correlate_magnitude_normalized_rows(correlations, sss_res, matrix, norms);
+}
@@ -148,6 +148,73 @@ void symbol::channel_estimate(
   this->is_equalized = true;
 }
 
+/** 
+ * Equalizes only the given data REs, estimating the channel over the span from
+ * the first data RE to the last DMRS. The result, and its scale, are those of
+ * channel_estimate() on an unequalized symbol followed by gathering samples_eq
+ * at data_indices, but the symbol is not modified.
+ */
+void symbol::equalize_res(
+  vector<complex<float>>& output,
+  span<const complex<float>> dmrs_reference,
+  span<const uint64_t> dmrs_indices,
+  span<const uint16_t> data_indices) const
+{
+  static thread_local vector<complex<float>> channel;
+  static thread_local vector<complex<float>> data_channel;
+  static thread_local vector<float> channel_magnitude;
+
+  output.resize(data_indices.size());
+  if (data_indices.empty() || dmrs_indices.empty() || dmrs_indices.size() > dmrs_reference.size()) {
+    SPDLOG_ERROR("Invalid DMRS or data indices for equalization");
+    return;
+  }
+
+  uint64_t span_start = data_indices.front();
+  uint64_t span_end = dmrs_indices.back() + 1;
+  channel.resize(span_end - span_start);
+
+  // Channel at the DMRS, linearly interpolated in between. Before the first
+  // DMRS it is interpolated from 1, like the untouched channel_filter.
+  uint64_t prev = span_start;
+  complex<float> prev_value(1.0f, 0.0f);
+  channel[0] = prev_value;
+  for (size_t i = 0; i < dmrs_indices.size(); i++) {
+    uint64_t dmrs_index = dmrs_indices[i];
+    assert(prev <= dmrs_index);
+    complex<float> value = samples[dmrs_index] * conj(dmrs_reference[i]);
+    channel[dmrs_index - span_start] = value;
+
+    uint64_t distance = dmrs_index - prev;
+    if (distance > 1) {
+      complex<float> step = (value - prev_value) / static_cast<float>(distance);
+      complex<float>* out = channel.data() + (prev - span_start);
+      for (uint64_t j = 1; j < distance; j++) {
+        out[j] = prev_value + step * static_cast<float>(j);
+      }
+    }
+    prev = dmrs_index;
+    prev_value = value;
+  }
+
+  // The normalization averages over the whole symbol, where the channel outside the span is 1
+  channel_magnitude.resize(channel.size());
+  volk_32fc_magnitude_32f(channel_magnitude.data(), channel.data(), channel.size());
+  float total = 0;
+  volk_32f_accumulator_s32f(&total, channel_magnitude.data(), channel_magnitude.size());
+  float average_channel_magnitude = (total + (samples.size() - channel.size())) / samples.size();
+  float scale = 1.0f / (average_channel_magnitude * average_channel_magnitude);
+
+  data_channel.resize(data_indices.size());
+  for (size_t i = 0; i < data_indices.size(); i++) {
+    uint16_t data_index = data_indices[i];
+    output[i] = samples[data_index];
+    data_channel[i] = data_index < span_end ? channel[data_index - span_start] : complex<float>(1.0f, 0.0f);
+  }
+  volk_32fc_x2_multiply_conjugate_32fc(output.data(), output.data(), data_channel.data(), output.size());
+  volk_32f_s32f_multiply_32f(reinterpret_cast<float*>(output.data()), reinterpret_cast<const float*>(output.data()), scale, 2 * output.size());
+}
+
 /** 
  * Get average magnitude of the noise over the subcarriers of the symbol.
  */
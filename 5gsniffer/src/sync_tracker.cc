@@ -0,0 +1,59 @@
+#include "sync_tracker.h"
+#include <cmath>
+#include <spdlog/spdlog.h>
+
+namespace nr {
+  pss_window::pss_window(double expected_pss, size_t margin, size_t window_length, float resampling_rate, unsigned int delay) :
+    transient(std::ceil(2 * delay * resampling_rate)),
+    resampling_rate(resampling_rate),
+    delay(delay) {
+    // Output k of the downsampler is centered on input k / resampling_rate - delay
+    input_start = std::floor(expected_pss - margin / resampling_rate) - delay;
+    input_length = std::ceil((transient + window_length + 1) / resampling_rate);
+  }
+
+  double pss_window::position(double lag) const {
+    return input_start + (transient + lag) / resampling_rate - delay;
+  }
+
+  sync_tracker::sync_tracker(float timing_gain, float drift_gain, float cfo_gain, float min_correlation, uint32_t max_misses) :
+    timing_gain(timing_gain),
+    drift_gain(drift_gain),
+    cfo_gain(cfo_gain),
+    min_correlation(min_correlation),
+    max_misses(max_misses) {
+  }
+
+  void sync_tracker::reset(float cfo_) {
+    cfo = cfo_;
+    drift = 0;
+    correction = 0;
+    misses = 0;
+  }
+
+  bool sync_tracker::update(float timing_error, float cfo_error, float correlation) {
+    if (!(correlation >= min_correlation)) {
+      SPDLOG_DEBUG("[TRACKING] rejected SSB, correlation {} below {}", correlation, min_correlation);
+      miss();
+      return false;
+    }
+
+    drift += drift_gain * timing_error;
+    correction += timing_gain * timing_error + drift;
+    cfo += cfo_gain * cfo_error;
+    misses = 0;
+    SPDLOG_DEBUG("[TRACKING] timing_error={} drift={} cfo_error={} cfo={} correlation={}", timing_error, drift, cfo_error, cfo, correlation);
+    return true;
+  }
+
+  void sync_tracker::miss() {
+    correction += drift;
+    misses++;
+  }
+
+  int64_t sync_tracker::take_slip() {
+    int64_t slip = static_cast<int64_t>(std::trunc(correction));
+    correction -= slip;
+    return slip;
+  }
+}
@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <cstdint>
 #include <memory>
 #include <string>
@@ -11,6 +12,7 @@
 #include "syncer.h"
 #include "spdlog/spdlog.h"
 #include "dsp.h"
+#include "fft_plan.h"
 #include "utils.h"
 #include "ofdm.h"
 #include "ssb_mapper.h"
@@ -31,39 +33,55 @@ using namespace std;
  */
 // MHZ - Pass zmq_address
 syncer::syncer(uint64_t sample_rate, shared_ptr<nr::phy> phy, const std::string& zmq_address) :
+  // Create pool of 64 flows that can process samples in parallel after synchronization
+  syncer(sample_rate, phy, make_shared<nr::flow_pool>(64, zmq_address), config.nid_2, false) {
+  this->zmq_address = zmq_address;
+}
+
+/** 
+ * Constructor for syncer.
+ *
+ * @param nid_2 NID2 to look for, or any above 2 to look for all of them
+ */
+syncer::syncer(uint64_t sample_rate, shared_ptr<nr::phy> phy, shared_ptr<nr::flow_pool> flow_pool, uint8_t nid_2, bool copy_input) :
   sample_rate(sample_rate),
   phy(phy),
-  zmq_address(zmq_address) {
-  // Reserve some space for the processing queue
-  processing_queue.reserve(1024*1024);
+  flows(make_shared<nr::flow_group>(flow_pool)),
+  copy_input(copy_input),
+  expected_nid1(-1) {
+  processing_queue = make_shared<vector<complex<float>>>();
+  queue_start = 0;
+  queue_zeros = 0;
 
   // Generate all needed PSS and SSS signals
   psss.push_back(pss(0));
   psss.push_back(pss(1));
   psss.push_back(pss(2));
 
-  sss sss_ref(0,0);
-  std::array <std::array<std::complex<float>,sss_length>,nid_max+1> ssss = sss_ref.generate_all_sss_seq();
-  phy->ssss = ssss;
+  // The SSS of all cells are generated once, and shared by every syncer
+  sss_table::get();
   // Setup resampler
   unsigned int h_len = 51;                               // Filter semi-length (filter delay)
   resampling_rate = (float)phy->ssb_bwp->sample_rate / (float)sample_rate; // Resampling rate (output/input)
-  max_resampled_samples_per_sample = (unsigned int)ceilf(resampling_rate);
   float bw = 0.08f;                                       // Resampling filter bandwidth TODO this parameter is important
   float slsl = 70.0f;                                    // Resampling filter sidelobe suppression level
-  unsigned int npfb = 16;                                // Number of filters in bank (timing resolution)
-  resampler = resamp_crcf_create(resampling_rate, h_len, bw, slsl, npfb);
+  unsigned int npfb = 16;                                // Number of filters in bank (timing resolution), only for non-integer rates
+  downsampler = make_unique<decimator>(sample_rate, phy->ssb_bwp->sample_rate, h_len, bw, slsl, npfb);
 
   // Look for a given PSS index as specified in the config file
-  if (config.nid_2 < 3){
-    pss_start = config.nid_2;
-    pss_end = config.nid_2;
+  if (nid_2 < 3){
+    pss_start = nid_2;
+    pss_end = nid_2;
   }
   // Look for all PSS indexes, nid_2 not specified in the config
   else{ 
     pss_start = 0;
     pss_end = 2;
   }
+
+  build_pss_correlator();
+
+  tracker = nr::sync_tracker(0.5f, 0.05f, 0.5f, config.tracking_min_correlation, config.tracking_max_misses);
   
   state = syncer::state::find_pss;
   cfo = 0.0f;
@@ -74,18 +92,50 @@ syncer::syncer(uint64_t sample_rate, shared_ptr<nr::phy> phy, const std::string&
   ssb_period = 0.02; // SSB periodicity is 20 ms for initial access.
   // Window size to look for PSS after we are already sync. 8 OFDM symbols 
   pss_window_size = std::floor((float)sample_rate /(float)(phy->ssb_bwp->scs) * 8);
- 
-  // Create pool of 64 flows that can process samples in parallel after synchronization
-  // MHZ - Pass zmq_address
-  flow_pool = make_shared<nr::flow_pool>(64, this->zmq_address);
-  this->connect(flow_pool);
+
+  this->connect(flows);
 }
 
 /** 
  * Destructor for syncer.
  */
 syncer::~syncer() {
-  resamp_crcf_destroy(resampler);
+}
+
+/**
+ * Builds the frequency-domain correlator against the PSS of pss_start..pss_end.
+ * The PSS spectra are computed once, and each block of samples is transformed
+ * once for all of them.
+ */
+void syncer::build_pss_correlator() {
+  vector<vector<complex<float>>> pss_references;
+  for (uint8_t pss_idx = pss_start; pss_idx <= pss_end; pss_idx++) {
+    auto pss_seq_t = psss[pss_idx].get_pss_seq_t();
+    pss_references.emplace_back(pss_seq_t.begin(), pss_seq_t.end());
+  }
+  pss_correlator = make_unique<overlap_save_correlator>(pss_references);
+}
+
+/**
+ * Starts from a cell found by a cell search in the last num_samples samples,
+ * whose SSB slot starts at slot_start in them. The PSS is then only searched
+ * around the next SSB, and the PBCH is decoded with the PCI of the cell.
+ */
+void syncer::expect_cell(uint16_t nid1, int64_t slot_start, size_t num_samples) {
+  expected_nid1 = nid1;
+  phy->nid1 = nid1;
+  phy->nid2 = pss_start;
+  phy->in_synch = true;
+  waiting_for_pss = static_cast<int64_t>(num_samples) - slot_start;
+  state = state::wait;
+}
+
+/**
+ * True once the MIB was decoded and the SSBs are followed, including while
+ * tracking.
+ */
+bool syncer::is_synchronized() const {
+  return phy->in_synch && phy->bandwidth_parts.size() > 0 && (state == state::wait || state == state::track || state == state::relay);
 }
 
 /** 
@@ -100,13 +150,26 @@ void syncer::process(shared_ptr<vector<complex<float>>>& samples, int64_t metada
   // Apply frequency correction to new samples
   SPDLOG_DEBUG("Applying CFO {} to new samples coming to the processing queue counter", -cfo);
 
-  rotate(*samples.get(), *samples.get(), -cfo, sample_rate);   
-  // Add the samples to the processing queue
-  processing_queue = std::move(*samples.get());
+  if (copy_input) {
+    // The chunk is shared with other workers, so the CFO is applied into a buffer of this syncer, reused once the flows no longer hold it
+    shared_ptr<vector<complex<float>>> buffer = std::move(processing_queue);
+    if (!buffer || buffer.use_count() > 1) {
+      buffer = make_shared<vector<complex<float>>>();
+    }
+    buffer->resize(samples->size());
+    rotate(*buffer, *samples, -cfo, sample_rate);
+    processing_queue = std::move(buffer);
+  } else {
+    rotate(*samples.get(), *samples.get(), -cfo, sample_rate);   
+    // The chunk becomes the processing queue, and is handed on to the next workers as views of it
+    processing_queue = samples;
+  }
+  queue_start = 0;
+  queue_zeros = 0;
 
   if (state == state::reset) {
     // Clear processing queues
-    processing_queue.clear();
+    processing_queue->clear();
     downsampled_samples.clear();
 
     // Clear all bandwidth parts and flows
@@ -126,22 +189,26 @@ void syncer::process(shared_ptr<vector<complex<float>>>& samples, int64_t metada
     phy->in_synch = false;
     SPDLOG_DEBUG("PSS tracking failed resetting");
    } else {
-    waiting_for_pss += processing_queue.size();
+    waiting_for_pss += processing_queue->size();
    } 
   }
 
   if (state == state::wait){
-     if ((waiting_for_pss > sample_rate * ssb_period) & (waiting_for_pss - processing_queue.size() < sample_rate * ssb_period)){ // We have to account for the previous chunk of 8 ms where we found SSB and we send already and then we started counting after that.
-      state = state::find_pss;
+     if ((waiting_for_pss > sample_rate * ssb_period) & (waiting_for_pss - processing_queue->size() < sample_rate * ssb_period)){ // We have to account for the previous chunk of 8 ms where we found SSB and we send already and then we started counting after that.
+      // Once synchronized, the SSB only updates the tracking loops instead of going through the whole acquisition again
+      state = (config.tracking && phy->bandwidth_parts.size() > 0) ? state::track : state::find_pss;
      } else {
-      int sent_samples_size = processing_queue.size();
-      shared_ptr<vector<complex<float>>> processing_queue_ptr = make_shared<vector<complex<float>>>(std::move(processing_queue)); // TODO allocate processing_queue on the heap in the first place so we don't need to do this copy
-      send_to_next_workers(processing_queue_ptr, counting_samples);
-      counting_samples = counting_samples + sent_samples_size;
-      processing_queue.clear();
+      relay_queue();
      }
   }
 
+  if (state == state::track) {
+    SPDLOG_DEBUG("Tracking SSB");
+    auto track_t0 = time_profile_start();
+    track();
+    time_profile_end(track_t0, "syncer::track");
+  }
+
   if (state == state::find_pss) {
     SPDLOG_DEBUG("Looking for PSS");
     auto find_pss_t0 = time_profile_start();
@@ -162,32 +229,45 @@ void syncer::process(shared_ptr<vector<complex<float>>>& samples, int64_t metada
   } 
   
   if(state == state::relay) {
-    waiting_for_pss = processing_queue.size();
-    int sent_samples_size = processing_queue.size();
-    shared_ptr<vector<complex<float>>> processing_queue_ptr = make_shared<vector<complex<float>>>(std::move(processing_queue)); // TODO allocate processing_queue on the heap in the first place so we don't need to do this copy
-    send_to_next_workers(processing_queue_ptr, counting_samples);
-    counting_samples = counting_samples + sent_samples_size;
-
-    processing_queue.clear();
+    waiting_for_pss = queue_size();
+    relay_queue();
     state = state::wait;
   }
 }
 
+/**
+ * Number of samples left to relay: the zeros delaying the queue, and the
+ * queue from its start.
+ */
+size_t syncer::queue_size() const {
+  return queue_zeros + processing_queue->size() - queue_start;
+}
+
+/**
+ * Sends the rest of the processing queue to the next workers, as views of the
+ * zeros delaying it and of the queue itself, so the samples are not copied.
+ */
+void syncer::relay_queue() {
+  if (queue_zeros > 0) {
+    send_to_next_workers(sample_view::zeros(queue_zeros), counting_samples);
+    counting_samples = counting_samples + queue_zeros;
+    queue_zeros = 0;
+  }
+  size_t remaining = processing_queue->size() - queue_start;
+  if (remaining > 0) {
+    send_to_next_workers(sample_view(processing_queue, queue_start, remaining), counting_samples);
+    counting_samples = counting_samples + remaining;
+  }
+  queue_start = processing_queue->size();
+}
+
 /**
  * Downsample the signal given by the samples currently in the processing queue.
  *
  * @param num_samples number of samples to downsample
  */
 void syncer::downsample(uint64_t num_samples, int64_t start_sample, int64_t end_sample) {
-  for(int64_t i = start_sample; i < end_sample; i++) {
-    complex<float> temp[max_resampled_samples_per_sample]; // Temporary buffer for each resampling operation
-
-    uint32_t num_written;
-    resamp_crcf_execute(resampler, processing_queue.at(i), temp, &num_written);
-    for(int64_t j = 0; j < num_written; j++) {
-      downsampled_samples.push_back(temp[j]);
-    }
-  }
+  downsampler->execute({processing_queue->data() + start_sample, static_cast<size_t>(end_sample - start_sample)}, downsampled_samples);
 }
 
 /**
@@ -199,35 +279,36 @@ void syncer::find_pss() {
   uint64_t ssb_num_samples = ceilf(ssb_num_samples_downsampled / resampling_rate);
 
   // We want 10 symbols to have sufficient size for the fine sync correlation
-  if (processing_queue.size() > ssb_num_samples) {
+  if (processing_queue->size() > ssb_num_samples) {
     // Downsample the signal to span the SSB subcarriers and push to internal buffer
     downsampled_samples.clear();
-    downsampled_samples.reserve(processing_queue.size() - ssb_num_samples); 
+    downsampled_samples.reserve(processing_queue->size() - ssb_num_samples); 
     int64_t start_sample, end_sample;
     int64_t downsampled_offset;
 
     // Only look for PSS in a window of samples, as we already have a coarse estimation where it will be
     if (phy->in_synch){
-      start_sample = max(int64_t(0),int64_t((sample_rate * ssb_period - (waiting_for_pss - processing_queue.size()) - pss_window_size)));
-      end_sample =  min(int64_t(processing_queue.size()),int64_t(start_sample + pss_window_size*2 + 1)); 
+      start_sample = max(int64_t(0),int64_t((sample_rate * ssb_period - (waiting_for_pss - processing_queue->size()) - pss_window_size)));
+      end_sample =  min(int64_t(processing_queue->size()),int64_t(start_sample + pss_window_size*2 + 1)); 
       downsampled_offset = (start_sample+1)*resampling_rate;
     }else{
       start_sample = 0;
-      end_sample = processing_queue.size(); // Look for SSB only in the first half for speed during initial synch.
+      end_sample = processing_queue->size(); // Look for SSB only in the first half for speed during initial synch.
       downsampled_offset = 0;
      }
-    downsample(processing_queue.size() - ssb_num_samples, start_sample, end_sample);
+    downsample(processing_queue->size() - ssb_num_samples, start_sample, end_sample);
     // Dot product with the possible PSS
     bool pss_found = false;
     int64_t timing_error = 0;
     int64_t timing_error_downsampled_offset = 0;
     float max_corr = 0.0;
     uint8_t nid2 = 0;
+    // Correlate with every PSS in the frequency domain
+    vector<vector<float>> pss_correlations;
+    pss_correlator->correlate_magnitude(pss_correlations, downsampled_samples);
     for(uint8_t pss_idx = pss_start; pss_idx <= pss_end; pss_idx++) {
-      vector<float> correlation_magnitudes;
-      // Correlate
+      vector<float>& correlation_magnitudes = pss_correlations.at(pss_idx - pss_start);
       int step_size = 1;
-      correlate_magnitude(correlation_magnitudes, downsampled_samples, {psss[pss_idx].get_pss_seq_t().data(), psss[pss_idx].get_pss_seq_t().size()}, step_size);
 
       // Get the average
       float avg_correlation = 0.0f;
@@ -275,7 +356,7 @@ void syncer::find_pss() {
       state = state::fine_sync;
     } else {
       SPDLOG_DEBUG("PSS Not Found, sending to next worker all except a window at the end in case PSS is in between chunks");
-      counting_samples = counting_samples + processing_queue.size();
+      counting_samples = counting_samples + processing_queue->size();
 
     }
   }
@@ -291,11 +372,8 @@ void syncer::fine_sync() {
   uint16_t symbol_length = useful_length + cp_length;
   vector<complex<float>> correlations;
 
-  vector<complex<float>> delayed_samples(downsampled_samples);
-  vector<complex<float>> zeros(useful_length);
-  delayed_samples.insert(delayed_samples.begin(), zeros.begin(), zeros.end());
-  
-  moving_correlate(correlations, {downsampled_samples.data(), downsampled_samples.size()}, {delayed_samples.data(), downsampled_samples.size()}, cp_length);
+  // Correlates the samples with themselves one useful symbol length earlier
+  moving_correlate_delayed(correlations, downsampled_samples, useful_length, cp_length);
 
   // Since we are aligned to the PSS, the locations of normal cyclic
   // prefixes will be at symbol length *1,*2,*3, and *4 after correlation with
@@ -308,7 +386,7 @@ void syncer::fine_sync() {
 
   // Perform the new CFO immediately.
   rotate(downsampled_samples, downsampled_samples, -new_cfo_fine, phy->ssb_bwp->sample_rate);
-  rotate(processing_queue, processing_queue, -new_cfo_fine, sample_rate);
+  rotate(*processing_queue, *processing_queue, -new_cfo_fine, sample_rate);
 
   state = state::find_sss;
 }
@@ -323,16 +401,26 @@ void syncer::find_sss() {
   ssb_mapper->on_sss_found = std::bind(&syncer::on_sss_found, this, std::placeholders::_1);
   ssb_mapper->on_sss_not_found = std::bind(&syncer::on_sync_lost, this);
   ssb_mapper->pbch.on_mib_found = std::bind(&syncer::on_mib_found, this, std::placeholders::_1,std::placeholders::_2);
+  // Without a configured NID2, the strongest PSS may belong to another cell than the strongest SSS, so the SSS decides
+  ssb_mapper->joint_nid2 = pss_start != pss_end;
 
   // Make connections
   ofdm.connect(ssb_mapper);
 
   // Process downsampled SSB block
-  auto downsampled_samples_ptr = make_shared<vector<complex<float>>>(downsampled_samples);  // TODO allocate downsampled_samples on the heap in the first place so we don't need to do this copy
+  // The SSB is not needed after demodulation, so it is moved rather than copied
+  auto downsampled_samples_ptr = make_shared<vector<complex<float>>>(std::move(downsampled_samples));
+  downsampled_samples.clear();
   ofdm.process(downsampled_samples_ptr, 0);
 }
 
 void syncer::on_sss_found(uint16_t nid1) {
+  if (expected_nid1 >= 0) {
+    // The PBCH decides whether the expected cell is there
+    SPDLOG_DEBUG("Keeping PHY NID1 {} of the expected cell, strongest SSS is NID1 {}", expected_nid1, nid1);
+    this->phy->nid1 = expected_nid1;
+    return;
+  }
   SPDLOG_DEBUG("Setting PHY NID1 to {}", nid1);
   this->phy->nid1 = nid1;
 }
@@ -341,7 +429,7 @@ void syncer::on_sync_lost() {
   SPDLOG_DEBUG("Lost sync! Retrying to find PSS.");
   state = state::find_pss; // TODO if it failed multiple times, do a full reset?
   //state = state::reset;
-  counting_samples = counting_samples + processing_queue.size();
+  counting_samples = counting_samples + processing_queue->size();
 }
 
 void syncer::on_mib_found(srsran_mib_nr_t& mib, bool found) {
@@ -356,7 +444,8 @@ void syncer::on_mib_found(srsran_mib_nr_t& mib, bool found) {
 
   // Update the total CFO so it is applied next time
   cfo = new_cfo_fine;
-  rotate(processing_queue, processing_queue, -new_cfo_fine, sample_rate);
+  tracker.reset(cfo);
+  rotate(*processing_queue, *processing_queue, -new_cfo_fine, sample_rate);
 
   SPDLOG_DEBUG("CFO fine (Hz) applied after finding MIB: {}", cfo);
 
@@ -409,9 +498,10 @@ void syncer::on_mib_found(srsran_mib_nr_t& mib, bool found) {
   for(int i = 0; i < phy->bandwidth_parts.size(); i++) {
       auto bwp = phy->bandwidth_parts.at(i);
       auto mapper = phy->channel_mappers.at(i);
-      auto flow = flow_pool->acquire_flow();
+      auto flow = flows->acquire_flow();
       auto rotator = make_shared<class rotator>(this->sample_rate, (float)mapper->pdcch.subcarrier_offset*(float)bwp->scs);
       auto ofdm = make_shared<class ofdm>(bwp);
+      ofdm->set_symbol_indices(mapper->get_symbol_indices()); // Only the CORESET symbols are demodulated
       flow->connect(rotator);
       rotator->connect(ofdm);
       ofdm->connect(mapper); // Connect OFDM block to the shared PHY-layer channel mapper
@@ -419,8 +509,11 @@ void syncer::on_mib_found(srsran_mib_nr_t& mib, bool found) {
 
   // Locking the PSS and SSS to the synch'ed values
   phy->in_synch = true;
-  pss_start = phy->nid2;
-  pss_end = phy->nid2;
+  if (pss_start != phy->nid2 || pss_end != phy->nid2) {
+    pss_start = phy->nid2;
+    pss_end = phy->nid2;
+    build_pss_correlator();
+  }
   SPDLOG_DEBUG("In synch, locking PSS = {}, SSS = {}, Cell ID = {} \n ",phy->nid2, phy->nid1, phy->get_cell_id());
   this->state = state::relay;
   }
@@ -433,7 +526,7 @@ void syncer::fine_time_sync() {
   uint64_t start_offset = num_zeros / 2;
 
   // TODO this is actually OFDM modulation. Make OFDM modulator block and add PSS / PBCH DMRS as well to improve correlation
-  auto sss_samples_f = phy->ssss.at((phy->nid1)*3 + phy->nid2);
+  auto sss_samples_f = sss_table::get().get_sss_seq(phy->nid1, phy->nid2);
   sss_full_rate.insert(sss_full_rate.begin()+start_offset, sss_samples_f.begin(), sss_samples_f.end());
   sss_full_rate.resize(initial_bwp->fft_size);
   
@@ -441,11 +534,10 @@ void syncer::fine_time_sync() {
   std::rotate(sss_full_rate.begin(), sss_full_rate.begin() + sss_full_rate.size() / 2, sss_full_rate.end());
   
   // IFFT
-  int flags = 0;
-  vector<complex<float>> sss_full_rate_time(initial_bwp->fft_size, 0);
-  fftplan q = fft_create_plan(initial_bwp->fft_size, sss_full_rate.data(), sss_full_rate_time.data(), LIQUID_FFT_BACKWARD, flags);
-  fft_execute(q);
-  fft_destroy_plan(q);
+  nr::fft_plan& ifft = nr::fft_plan::get(initial_bwp->fft_size, false);
+  std::copy(sss_full_rate.begin(), sss_full_rate.end(), ifft.input().begin());
+  ifft.execute();
+  vector<complex<float>> sss_full_rate_time(ifft.output().begin(), ifft.output().end());
 
   // Correlate
   vector<float> correlation_magnitudes;
@@ -455,7 +547,7 @@ void syncer::fine_time_sync() {
   assert(search_space_start >= 0);
   uint64_t search_space_size = initial_bwp->samples_per_symbol(4) * 2; // Search max 2 symbols
 
-  correlate_magnitude(correlation_magnitudes, {processing_queue.data() + search_space_start, search_space_size}, sss_full_rate_time);
+  correlate_magnitude(correlation_magnitudes, {processing_queue->data() + search_space_start, search_space_size}, sss_full_rate_time);
   for(int64_t i = 0; i < correlation_magnitudes.size(); i++) {
     if(correlation_magnitudes.at(i) >= correlation_max) {
       sss_position = i;
@@ -475,25 +567,125 @@ void syncer::fine_time_sync() {
   SPDLOG_DEBUG("Fine timing offset based on full-rate SSS: {}", timing_error);
 
   if(timing_error > 0) {
-    /* This could be optimized */
-    vector<complex<float>> queue_remainder(timing_error);
-    std::copy(processing_queue.begin(), processing_queue.begin() + timing_error, queue_remainder.begin());
-
-    // Send the part that will be erased from the processing queue to any existing flows, so they can still process these samples
-    shared_ptr<vector<complex<float>>> processing_queue_remainder = make_shared<vector<complex<float>>>(std::move(queue_remainder));
-    send_to_next_workers(processing_queue_remainder, counting_samples);
-    counting_samples = counting_samples + processing_queue_remainder->size();
-      
+    // Send the part that is dropped from the processing queue to any existing flows, so they can still process these samples
+    send_to_next_workers(sample_view(processing_queue, 0, timing_error), counting_samples);
+    counting_samples = counting_samples + timing_error;
 
     // Tell all currently existing flows to finish processing after the workload they received now
-    this->flow_pool->release_flows();
+    this->flows->release_flows();
 
     // Cut the processing queue
-    processing_queue.erase(processing_queue.begin(), processing_queue.begin()+timing_error);
+    queue_start = timing_error;
   } else {
-    // If the correlation is higher for negative offsets, we need to append samples
-    for(int i = 0; i < abs(timing_error); i++) {
-      processing_queue.insert(processing_queue.begin(), complex<float>(0));
+    // If the correlation is higher for negative offsets, the queue is delayed by zeros
+    queue_zeros = -timing_error;
+  }
+}
+
+/**
+ * Updates the timing and CFO tracking loops from the SSB expected in the
+ * processing queue, and relays the queue to the flows that are already
+ * running. The PSS is only searched within a CP of its expected position, and
+ * the CFO residual is measured on the CPs of the SSB as in fine_sync. Timing
+ * corrections are applied by dropping or inserting samples at the start of
+ * the SSB slot. Falls back to a full acquisition when the lock is lost.
+ */
+void syncer::track() {
+  auto initial_bwp = phy->get_initial_dl_bandwidth_part();
+  auto ssb_bwp = phy->ssb_bwp;
+
+  // Expected start of the SSB slot in the processing queue (full-rate), and of the useful part of the PSS.
+  // fine_time_sync aligns the slot slightly (1%) into the CP, so the PSS is that much later.
+  int64_t slot_start = static_cast<int64_t>(sample_rate * ssb_period) - (waiting_for_pss - static_cast<int64_t>(processing_queue->size()));
+  float expected_pss = slot_start + initial_bwp->samples_per_symbol(0) + initial_bwp->samples_per_symbol(1) + initial_bwp->samples_per_cp(2) + std::floor(0.01 * initial_bwp->samples_per_cp(0));
+
+  // Downsampled window of a CP either side of the PSS, long enough for the CFO measurement on the next symbols
+  uint16_t margin = ssb_bwp->samples_per_cp(1);
+  uint16_t useful_length = ssb_bwp->fft_size;
+  uint16_t cp_length = ssb_bwp->samples_per_cp(1);
+  uint16_t symbol_length = useful_length + cp_length;
+  size_t window_length = 2 * margin + 5 * symbol_length;
+  // Outputs whose filter window reaches before the input are dropped
+  nr::pss_window search(expected_pss, margin, window_length, resampling_rate, downsampler->get_delay());
+  int64_t input_start = search.input_start;
+  int64_t input_length = search.input_length;
+  size_t transient = search.transient;
+
+  bool measurable = false;
+  if (slot_start >= 0 && input_start >= 0 && input_start + input_length <= static_cast<int64_t>(processing_queue->size())) {
+    downsampled_samples.clear();
+    downsampler->reset();
+    downsampler->execute({processing_queue->data() + input_start, static_cast<size_t>(input_length)}, downsampled_samples);
+
+    if (downsampled_samples.size() >= transient + window_length) {
+      span<complex<float>> window(downsampled_samples.data() + transient, window_length);
+
+      // Normalized PSS correlation over the lags of the window
+      auto pss_seq_t = psss[phy->nid2].get_pss_seq_t();
+      vector<float> correlations;
+      correlate_magnitude_normalized(correlations, window.subspan(0, 2 * margin + pss_seq_t.size()), pss_seq_t);
+      size_t peak = std::max_element(correlations.begin(), correlations.end()) - correlations.begin();
+
+      // A peak on the edge of the window is outside it, and not a measurement
+      if (peak > 0 && peak + 1 < correlations.size()) {
+        // Parabolic interpolation of the peak for a sub-sample position
+        float left = correlations[peak - 1], center = correlations[peak], right = correlations[peak + 1];
+        float denominator = left - 2 * center + right;
+        float fraction = denominator != 0 ? 0.5f * (left - right) / denominator : 0.0f;
+        float pss_position = search.position(peak + fraction);
+        float timing_error = pss_position - expected_pss;
+
+        // CFO residual from the CPs of the symbols following the PSS CP
+        vector<complex<float>> cp_correlations;
+        size_t pss_cp_start = peak > ssb_bwp->samples_per_cp(2) ? peak - ssb_bwp->samples_per_cp(2) : 0;
+        moving_correlate_delayed(cp_correlations, window.subspan(pss_cp_start), useful_length, cp_length);
+        complex<float> average = cp_correlations[symbol_length*1] + cp_correlations[symbol_length*2] + cp_correlations[symbol_length*3] + cp_correlations[symbol_length*4];
+        float cfo_error = ssb_bwp->scs * (std::arg(average) / (2*std::numbers::pi));
+
+        measurable = true;
+        tracker.update(timing_error, cfo_error, center);
+      }
     }
   }
+  if (!measurable) {
+    SPDLOG_DEBUG("[TRACKING] SSB not measurable in this chunk");
+    tracker.miss();
+  }
+
+  if (!tracker.is_locked()) {
+    SPDLOG_INFO("[TRACKING] Lost SSB tracking, acquiring the cell again");
+    phy->in_synch = false;
+    waiting_for_pss = 0;
+    state = state::find_pss;
+    return;
+  }
+
+  // Apply the new CFO to the rest of the queue right away, and to new samples from now on
+  float cfo_update = tracker.get_cfo() - cfo;
+  cfo = tracker.get_cfo();
+  rotate(*processing_queue, *processing_queue, -cfo_update, sample_rate);
+
+  // Drop the samples the PSS is late by, or insert the ones it is early by, so the flows stay aligned to the slots.
+  // Only the views sent to the flows change, the samples are not moved.
+  int64_t slip = tracker.take_slip();
+  slot_start = std::clamp(slot_start, int64_t(0), static_cast<int64_t>(processing_queue->size()));
+  if (slip != 0 && slot_start > 0) {
+    send_to_next_workers(sample_view(processing_queue, 0, slot_start), counting_samples);
+    counting_samples = counting_samples + slot_start;
+  }
+  if (slip > 0) {
+    slip = std::min(slip, static_cast<int64_t>(processing_queue->size()) - slot_start);
+    queue_start = slot_start + slip;
+  } else if (slip < 0) {
+    queue_start = slot_start;
+    queue_zeros = -slip;
+  }
+  if (slip != 0) {
+    SPDLOG_DEBUG("[TRACKING] slipped {} samples", slip);
+  }
+
+  // The next SSB is expected one period after the start of this slot
+  waiting_for_pss = slip != 0 ? queue_size() : queue_size() - slot_start;
+  relay_queue();
+  state = state::wait;
 }
@@ -37,6 +37,54 @@ shared_ptr<vector<complex<float>>> worker::produce_samples(size_t num_samples) {
   return make_shared<vector<complex<float>>>(vector<complex<float>>(num_samples));
 }
 
+/** 
+ * Processes a view of samples. Workers that only read their input can
+ * override this to avoid the copy; by default the whole buffer is handed on
+ * when the view covers it, and the viewed samples are copied otherwise.
+ *
+ * @param samples view of the samples to process
+ */
+void worker::process(const sample_view& samples, int64_t metadata) {
+  shared_ptr<vector<complex<float>>> buffer = samples.is_whole() ? samples.buffer : make_shared<vector<complex<float>>>(samples.samples().begin(), samples.samples().end());
+  this->process(buffer, metadata);
+}
+
+/** 
+ * Helper function to distribute a view of samples to the next workers,
+ * which share its buffer.
+ */
+void worker::send_to_next_workers(const sample_view& samples, int64_t metadata) {
+  for (const auto& worker : this->next_workers) {
+    worker->process(samples, metadata);
+  }
+}
+
+/** 
+ * Processes a grid of symbols. Workers that read the grid directly can
+ * override this; by default every row is copied into a symbol.
+ *
+ * @param grid OFDM symbols to process
+ */
+void worker::process(const shared_ptr<slot_grid>& grid, int64_t metadata) {
+  auto symbols = make_shared<vector<symbol>>();
+  symbols->reserve(grid->size());
+  for (size_t i = 0; i < grid->size(); i++) {
+    symbols->push_back(grid->to_symbol(i));
+  }
+  this->process(symbols, metadata);
+}
+
+/** 
+ * Helper function to distribute a grid of symbols to the next workers. The
+ * grid may be refilled once no worker holds it, so a worker that keeps it
+ * after processing must keep a copy of the shared_ptr.
+ */
+void worker::send_to_next_workers(const shared_ptr<slot_grid>& grid, int64_t metadata) {
+  for (const auto& worker : this->next_workers) {
+    worker->process(grid, metadata);
+  }
+}
+
 /** 
  * Used to connect other workers to this worker. A worker will ass a
  * shared_ptr to the sample buffer to all next workers for subsequent processing.
@@ -0,0 +1,62 @@
+#include "zmq_source.h"
+#include "spdlog/spdlog.h"
+#include <algorithm>
+#include <cstdint>
+
+using namespace std;
+
+// Time without a message after which the publisher is taken to have stopped
+static constexpr int receive_timeout_ms = 5000;
+
+/** 
+ * Constructor for zmq_source.
+ *
+ * @param address address of the ZMQ publisher, e.g. tcp://127.0.0.1:2000
+ */
+zmq_source::zmq_source(const string& address) :
+  socket(ctx, zmq::socket_type::sub) {
+  socket.set(zmq::sockopt::subscribe, "");
+  socket.set(zmq::sockopt::rcvtimeo, receive_timeout_ms);
+  socket.connect(address);
+  SPDLOG_DEBUG("Receiving samples from {}", address);
+}
+
+/** 
+ * Destructor for zmq_source.
+ */
+zmq_source::~zmq_source() {
+  socket.close();
+}
+
+/** 
+ * Receives messages until num_samples complex samples are available, or
+ * until no message arrives within the receive timeout, which ends the stream.
+ *
+ * @param num_samples number of samples to produce
+ */
+shared_ptr<vector<complex<float>>> zmq_source::produce_samples(size_t num_samples) {
+  auto buffer = make_shared<vector<complex<float>>>();
+  buffer->swap(leftover_samples);
+  buffer->reserve(num_samples);
+
+  while (buffer->size() < num_samples) {
+    zmq::message_t msg;
+    auto result = socket.recv(msg, zmq::recv_flags::none);
+    if (!result) {
+      SPDLOG_INFO("No samples received for {} ms, ending the stream", receive_timeout_ms);
+      this->on_end();
+      break;
+    }
+    auto data = msg.data<complex<float>>();
+    buffer->insert(buffer->end(), data, data + msg.size() / sizeof(complex<float>));
+  }
+
+  if (buffer->size() > num_samples) {
+    leftover_samples.assign(buffer->begin() + num_samples, buffer->end());
+    buffer->resize(num_samples);
+  }
+
+  SPDLOG_DEBUG("Received {} samples", buffer->size());
+  total_produced_samples += buffer->size();
+  return buffer;
+}
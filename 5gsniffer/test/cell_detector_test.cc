@@ -0,0 +1,84 @@
+#include <cmath>
+#include <complex>
+#include <numbers>
+#include <random>
+#include <vector>
+#include "gtest/gtest.h"
+#include "cell_detector.h"
+#include "pss.h"
+#include "sss.h"
+
+class cell_detector_test : public ::testing::Test {
+ protected:
+  cell_detector_test() {
+  }
+
+  static constexpr size_t cp_length = 18;
+
+  /* Adds the PSS and SSS of a cell, the useful part of the PSS starting at position */
+  void add_cell(std::vector<std::complex<float>>& samples, uint16_t nid1, uint8_t nid2, size_t position, float amplitude) {
+    auto pss_seq_t = pss(nid2).get_pss_seq_t();
+    for (size_t i = 0; i < ssb_nfft; i++) {
+      samples[position + i] += amplitude * pss_seq_t[i];
+    }
+
+    // SSS modulated on the subcarriers 64 below to 62 above DC
+    auto sss_seq = sss(0, 0).generate_all_sss_seq()[3 * nid1 + nid2];
+    size_t sss_position = position + 2 * (ssb_nfft + cp_length);
+    for (size_t t = 0; t < ssb_nfft; t++) {
+      std::complex<float> value = 0;
+      for (size_t j = 0; j < sss_length; j++) {
+        float phase = 2 * std::numbers::pi * (float)((j + ssb_nfft - 64) % ssb_nfft) * t / ssb_nfft;
+        value += sss_seq[j] * std::polar(1.0f, phase);
+      }
+      samples[sss_position + t] += amplitude * value / (float)ssb_nfft;
+    }
+  }
+};
+
+TEST_F(cell_detector_test, detects_cells_sharing_nid2) {
+  std::vector<std::complex<float>> samples(3000);
+  std::mt19937 generator(1);
+  std::normal_distribution<float> noise(0, 0.001f);
+  for (auto& sample : samples) {
+    sample = {noise(generator), noise(generator)};
+  }
+
+  /* Two cells with the same NID2 and SSB timing, and one with another NID2 */
+  add_cell(samples, 10, 1, 300, 1.0f);
+  add_cell(samples, 200, 1, 300, 0.8f);
+  add_cell(samples, 50, 2, 1500, 1.0f);
+
+  nr::cell_detector detector(0.3f, 8, cp_length);
+  std::vector<nr::cell_detector::detection> detections;
+  detector.detect(detections, samples);
+
+  ASSERT_EQ(detections.size(), 3);
+  std::vector<uint16_t> cell_ids;
+  for (const auto& detection : detections) {
+    cell_ids.push_back(detection.get_cell_id());
+    EXPECT_EQ(detection.pss_position, detection.nid2 == 1 ? 300 : 1500);
+    EXPECT_GE(detection.pss_correlation, 0.3f);
+  }
+  EXPECT_EQ(cell_ids, std::vector<uint16_t>({3 * 50 + 2, 3 * 10 + 1, 3 * 200 + 1}));
+
+  /* Only the strongest cells are reported */
+  nr::cell_detector single_detector(0.3f, 1, cp_length);
+  single_detector.detect(detections, samples);
+  ASSERT_EQ(detections.size(), 1);
+  EXPECT_EQ(detections[0].get_cell_id(), 3 * 50 + 2);
+}
+
+TEST_F(cell_detector_test, ignores_noise) {
+  std::vector<std::complex<float>> samples(3000);
+  std::mt19937 generator(2);
+  std::normal_distribution<float> noise(0, 1.0f);
+  for (auto& sample : samples) {
+    sample = {noise(generator), noise(generator)};
+  }
+
+  nr::cell_detector detector(0.3f, 8, cp_length);
+  std::vector<nr::cell_detector::detection> detections;
+  detector.detect(detections, samples);
+  EXPECT_TRUE(detections.empty());
+}
@@ -0,0 +1,129 @@
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "gtest/gtest.h"
+#include "dci_event_pipeline.h"
+
+class dci_event_pipeline_test : public ::testing::Test {
+ protected:
+  dci_event_pipeline_test() {
+  }
+
+  void SetUp() override {
+    saved_handler = nr::dci_event_pipeline::instance().get_handler();
+  }
+
+  void TearDown() override {
+    nr::dci_event_pipeline& pipeline = nr::dci_event_pipeline::instance();
+    pipeline.stop();
+    pipeline.set_handler(saved_handler);
+  }
+
+  nr::dci_event_pipeline::handler saved_handler;
+};
+
+TEST_F(dci_event_pipeline_test, payload) {
+  std::vector<uint8_t> bits(41);
+  for (size_t i = 0; i < bits.size(); i++) {
+    bits[i] = (i * 7 + i / 3) % 2;
+  }
+  nr::dci_record record{};
+  record.pack_payload(bits.data(), bits.size());
+  std::vector<uint8_t> unpacked(bits.size());
+  record.unpack_payload(unpacked.data());
+  EXPECT_EQ(record.nof_bits, bits.size());
+  EXPECT_EQ(unpacked, bits);
+}
+
+TEST_F(dci_event_pipeline_test, ring_drops_when_full) {
+  auto ring = std::make_unique<nr::spsc_ring<int, 4>>();
+  for (int i = 0; i < 4; i++) {
+    EXPECT_TRUE(ring->push(i));
+  }
+  EXPECT_FALSE(ring->push(4));
+  EXPECT_EQ(ring->get_dropped(), 1);
+
+  int value;
+  for (int i = 0; i < 4; i++) {
+    ASSERT_TRUE(ring->pop(value));
+    EXPECT_EQ(value, i);
+  }
+  EXPECT_FALSE(ring->pop(value));
+  EXPECT_TRUE(ring->empty());
+}
+
+TEST_F(dci_event_pipeline_test, consumer_keeps_order_per_thread) {
+  nr::dci_event_pipeline& pipeline = nr::dci_event_pipeline::instance();
+  std::mutex mutex;
+  std::vector<std::vector<int64_t>> handled(2);
+  pipeline.set_handler([&](const nr::dci_record& record) {
+    std::lock_guard<std::mutex> lock(mutex);
+    handled.at(record.rnti).push_back(record.sample_index);
+  });
+
+  /* Producers that outrun the consumer may drop records, but never reorder them */
+  pipeline.start();
+  std::vector<std::thread> producers;
+  std::vector<uint64_t> published(2, 0);
+  for (uint16_t thread_idx = 0; thread_idx < 2; thread_idx++) {
+    producers.emplace_back([&pipeline, &published, thread_idx]() {
+      for (int64_t i = 0; i < 5000; i++) {
+        nr::dci_record record{};
+        record.rnti = thread_idx;
+        record.sample_index = i;
+        published.at(thread_idx) += pipeline.publish(record);
+      }
+    });
+  }
+  for (std::thread& producer : producers) {
+    producer.join();
+  }
+  pipeline.stop();
+
+  uint64_t total = 0;
+  for (uint16_t thread_idx = 0; thread_idx < 2; thread_idx++) {
+    EXPECT_EQ(handled.at(thread_idx).size(), published.at(thread_idx));
+    EXPECT_TRUE(std::is_sorted(handled.at(thread_idx).begin(), handled.at(thread_idx).end()));
+    total += 5000 - published.at(thread_idx);
+  }
+  EXPECT_EQ(pipeline.get_dropped(), total);
+
+  /* Once stopped, records are handled on the publishing thread */
+  nr::dci_record record{};
+  record.rnti = 0;
+  record.sample_index = 5000;
+  EXPECT_TRUE(pipeline.publish(record));
+  EXPECT_EQ(handled.at(0).back(), 5000);
+}
+
+TEST_F(dci_event_pipeline_test, stop_while_publishing) {
+  nr::dci_event_pipeline& pipeline = nr::dci_event_pipeline::instance();
+  std::atomic<uint64_t> handled = 0;
+  pipeline.set_handler([&](const nr::dci_record& record) {
+    handled++;
+  });
+
+  /* Every record published around stop() is handled or counted as dropped */
+  uint64_t dropped = pipeline.get_dropped();
+  pipeline.start();
+  std::vector<std::thread> producers;
+  std::atomic<uint64_t> published = 0;
+  for (int thread_idx = 0; thread_idx < 4; thread_idx++) {
+    producers.emplace_back([&pipeline, &published]() {
+      for (int i = 0; i < 20000; i++) {
+        pipeline.publish(nr::dci_record{});
+        published++;
+      }
+    });
+  }
+  std::this_thread::yield();
+  pipeline.stop();
+  for (std::thread& producer : producers) {
+    producer.join();
+  }
+  EXPECT_EQ(handled + pipeline.get_dropped() - dropped, published);
+}
@@ -0,0 +1,64 @@
+#include <cstdint>
+#include <vector>
+#include <complex>
+#include <cmath>
+#include "gtest/gtest.h"
+#include "decimator.h"
+
+using namespace std;
+
+class decimator_test : public ::testing::Test {
+ protected:
+  decimator_test() {
+  }
+};
+
+TEST_F(decimator_test, integer_ratio) {
+  decimator dec(23'040'000, 3'840'000, 51, 0.08f, 70.0f, 16);
+  EXPECT_TRUE(dec.is_integer());
+  EXPECT_EQ(dec.get_factor(), 6);
+
+  /* Unity gain at DC once the filter is filled */
+  vector<complex<float>> ones(600, 1.0f);
+  vector<complex<float>> output;
+  dec.execute(ones, output);
+  ASSERT_EQ(output.size(), 100);
+  EXPECT_NEAR(std::abs(output.back() - complex<float>(1.0f, 0.0f)), 0, 1e-3);
+}
+
+TEST_F(decimator_test, state_across_blocks) {
+  vector<complex<float>> input(5000);
+  for (size_t i = 0; i < input.size(); i++) {
+    input[i] = std::polar(1.0f, 0.013f * i * i);
+  }
+
+  decimator whole(6, 1, 51, 0.08f, 70.0f, 16);
+  vector<complex<float>> expected;
+  whole.execute(input, expected);
+  EXPECT_EQ(expected.size(), (input.size() + 5) / 6);
+
+  /* Blocks of odd sizes give the same stream as one block */
+  decimator blocks(6, 1, 51, 0.08f, 70.0f, 16);
+  vector<complex<float>> output;
+  size_t block_sizes[] = {1, 7, 250, 3, 1000, 11};
+  size_t position = 0;
+  for (size_t i = 0; position < input.size(); i++) {
+    size_t size = std::min(block_sizes[i % 6], input.size() - position);
+    blocks.execute({input.data() + position, size}, output);
+    position += size;
+  }
+  ASSERT_EQ(output.size(), expected.size());
+  for (size_t i = 0; i < output.size(); i++) {
+    EXPECT_NEAR(std::abs(output[i] - expected[i]), 0, 1e-5);
+  }
+}
+
+TEST_F(decimator_test, fractional_ratio) {
+  decimator dec(25'000'000, 3'840'000, 51, 0.08f, 70.0f, 16);
+  EXPECT_FALSE(dec.is_integer());
+
+  vector<complex<float>> input(3000, 1.0f);
+  vector<complex<float>> output;
+  dec.execute(input, output);
+  EXPECT_NEAR(output.size(), input.size() * dec.get_rate(), 2);
+}
@@ -0,0 +1,53 @@
+#include <chrono>
+#include <thread>
+#include "gtest/gtest.h"
+#include "decode_scheduler.h"
+
+class decode_scheduler_test : public ::testing::Test {
+ protected:
+  decode_scheduler_test() {
+  }
+
+  void SetUp() override {
+    saved_state = nr::lag_controller::instance().save();
+  }
+
+  void TearDown() override {
+    nr::lag_controller::instance().restore(saved_state);
+  }
+
+  nr::lag_controller::state saved_state;
+};
+
+TEST_F(decode_scheduler_test, deadline) {
+  nr::decode_deadline unlimited(0);
+  nr::decode_deadline budget(1000);
+  EXPECT_FALSE(budget.expired());
+  std::this_thread::sleep_for(std::chrono::milliseconds(2));
+  EXPECT_TRUE(budget.expired());
+  EXPECT_FALSE(unlimited.expired());
+}
+
+TEST_F(decode_scheduler_test, lag_controller) {
+  nr::lag_controller& controller = nr::lag_controller::instance();
+  controller.restore({});
+  controller.configure(10);
+  EXPECT_EQ(controller.rnti_list_length(1000), 1000);
+
+  /* The sample time stands still while the wall time advances */
+  auto start = std::chrono::steady_clock::now();
+  controller.update(0.0, start);
+  controller.update(0.0, start + std::chrono::milliseconds(150));
+  EXPECT_EQ(controller.get_level(), 1);
+  EXPECT_EQ(controller.rnti_list_length(1000), 500);
+  EXPECT_EQ(controller.rnti_list_length(20), 16);
+  EXPECT_EQ(controller.min_agg_level(), 0);
+
+  /* Coverage changes are held for a while */
+  controller.update(0.0, start + std::chrono::milliseconds(200));
+  EXPECT_EQ(controller.get_level(), 1);
+
+  /* Catching up restores the coverage */
+  controller.update(0.3, start + std::chrono::milliseconds(300));
+  EXPECT_EQ(controller.get_level(), 0);
+}
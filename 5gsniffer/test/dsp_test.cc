@@ -1,6 +1,10 @@
+#include <chrono>
+#include <cmath>
 #include <cstdint>
+#include <iostream>
 #include <vector>
 #include <complex>
+#include <volk/volk.h>
 #include "gtest/gtest.h"
 #include "dsp.h"
 
@@ -27,3 +31,191 @@ TEST_F(dsp_test, correlation_magnitude_normalized) {
   correlate_magnitude_normalized(result, ref, random_corr);
   EXPECT_FLOAT_EQ(result.at(0), 0.238744325750948);
 }
+
+TEST_F(dsp_test, correlation_segments_normalized) {
+  vector<complex<float>> ref = {1+1j, 1+0j, 0+1j, 0+0.1j, 1-5j, 5+0j, -12-5j, 1-4j};
+  vector<complex<float>> rx = {4+4j, 4+0j, 0+4j, 0+0.4j, 1+1j, 1+0j, 0+1j, 0+0.1j};
+  vector<uint32_t> offsets = {0, 4, 8};
+  vector<float> ref_norms = {frobenius_norm({ref.data(), 4}), frobenius_norm({ref.data()+4, 4})};
+  vector<float> rx_norms = {frobenius_norm({rx.data(), 4}), frobenius_norm({rx.data()+4, 4})};
+
+  vector<float> result;
+  vector<float> expected;
+
+  correlate_segments_normalized(result, ref, rx, offsets, ref_norms, rx_norms);
+  ASSERT_EQ(result.size(), 2);
+  correlate_magnitude_normalized(expected, {ref.data(), 4}, {rx.data(), 4});
+  EXPECT_FLOAT_EQ(result.at(0), expected.at(0));
+  correlate_magnitude_normalized(expected, {ref.data()+4, 4}, {rx.data()+4, 4});
+  EXPECT_FLOAT_EQ(result.at(1), expected.at(0));
+}
+
+TEST_F(dsp_test, overlap_save_correlation) {
+  vector<vector<complex<float>>> refs(3, vector<complex<float>>(37));
+  vector<complex<float>> signal(1000);
+  uint32_t state = 1;
+  auto next = [&state]() {
+    state = state * 1103515245 + 12345;
+    return ((state >> 8) & 0xffff) / 32768.0f - 1.0f;
+  };
+  for (auto& ref : refs) {
+    for (auto& value : ref) {
+      value = {next(), next()};
+    }
+  }
+  for (auto& value : signal) {
+    value = {next(), next()};
+  }
+
+  /* Matches the time-domain correlation over several blocks, including a partial last block */
+  overlap_save_correlator correlator(refs);
+  vector<vector<float>> results;
+  correlator.correlate_magnitude(results, signal);
+  ASSERT_EQ(results.size(), refs.size());
+  for (size_t i = 0; i < refs.size(); i++) {
+    vector<float> expected;
+    correlate_magnitude(expected, signal, refs.at(i));
+    ASSERT_EQ(results.at(i).size(), expected.size());
+    for (size_t j = 0; j < expected.size(); j++) {
+      EXPECT_NEAR(results.at(i).at(j), expected.at(j), 1e-3 * (1 + expected.at(j)));
+    }
+  }
+}
+
+TEST_F(dsp_test, sliding_window_norms) {
+  vector<complex<float>> signal = {1+1j, 1+0j, 0+1j, 0+0.1j, 1-5j, 5+0j, -12-5j, 1-4j, 0+0j, 3+4j};
+  vector<float> result;
+
+  sliding_window_norms(result, signal, 4);
+  ASSERT_EQ(result.size(), signal.size() - 3);
+  for (size_t i = 0; i < result.size(); i++) {
+    EXPECT_FLOAT_EQ(result.at(i), frobenius_norm({signal.data() + i, 4}));
+  }
+
+  vector<uint32_t> offsets = {0, 3, 3, 10};
+  segment_norms(result, signal, offsets);
+  ASSERT_EQ(result.size(), 3);
+  EXPECT_FLOAT_EQ(result.at(0), frobenius_norm({signal.data(), 3}));
+  EXPECT_FLOAT_EQ(result.at(1), 0);
+  EXPECT_FLOAT_EQ(result.at(2), frobenius_norm({signal.data() + 3, 7}));
+}
+
+TEST_F(dsp_test, correlation_magnitude_normalized_zero_energy) {
+  vector<complex<float>> signal = {0+0j, 0+0j, 0+0j, 1+1j, 1+0j};
+  vector<complex<float>> ref = {1+1j, 1+0j};
+  vector<float> result;
+
+  /* Windows without energy correlate to 0 instead of NaN */
+  correlate_magnitude_normalized(result, signal, ref);
+  ASSERT_EQ(result.size(), 4);
+  EXPECT_FLOAT_EQ(result.at(0), 0);
+  EXPECT_FLOAT_EQ(result.at(1), 0);
+  EXPECT_FLOAT_EQ(result.at(3), 1);
+}
+
+TEST_F(dsp_test, correlation_magnitude_normalized_rows) {
+  vector<complex<float>> rx = {4+4j, 4+0j, 0+4j, 0+0.4j};
+  // Three real rows of length 4, the last one all zeros
+  vector<float> matrix = {1, -1, 1, 1,
+                          -2, 0.5, 3, 1,
+                          0, 0, 0, 0};
+  vector<float> norms = {2, std::sqrt(14.25f), 0};
+  vector<float> result;
+  vector<float> expected;
+
+  correlate_magnitude_normalized_rows(result, rx, matrix, norms);
+  ASSERT_EQ(result.size(), 3);
+  for (size_t i = 0; i < 2; i++) {
+    vector<complex<float>> row(matrix.begin() + i*4, matrix.begin() + (i+1)*4);
+    correlate_magnitude_normalized(expected, row, rx);
+    EXPECT_NEAR(result.at(i), expected.at(0), 1e-6);
+  }
+  EXPECT_EQ(result.at(2), 0);
+}
+
+TEST_F(dsp_test, DISABLED_benchmark_correlate_magnitude_normalized) {
+  vector<complex<float>> signal(20000);
+  vector<complex<float>> ref(127);
+  uint32_t state = 1;
+  auto next = [&state]() {
+    state = state * 1103515245 + 12345;
+    return ((state >> 8) & 0xffff) / 32768.0f - 1.0f;
+  };
+  for (auto& value : signal) {
+    value = {next(), next()};
+  }
+  for (auto& value : ref) {
+    value = {next(), next()};
+  }
+
+  /* Previous implementation, allocating and recomputing the norm of every window */
+  auto per_lag_norm = [](span<complex<float>> input) {
+    vector<float> magsq(input.size());
+    float mag_sum = 0.0f;
+    volk_32fc_magnitude_squared_32f(magsq.data(), input.data(), input.size());
+    volk_32f_accumulator_s32f(&mag_sum, magsq.data(), magsq.size());
+    return sqrt(mag_sum);
+  };
+  auto correlate_per_lag = [&per_lag_norm](vector<float>& output, span<complex<float>> a, span<complex<float>> b) {
+    output.resize(a.size() - b.size() + 1);
+    float b_norm = per_lag_norm(b);
+    for (size_t i = 0; i < output.size(); ++i) {
+      complex<float> dot_product = 0;
+      volk_32fc_x2_conjugate_dot_prod_32fc(&dot_product, a.data()+i, b.data(), b.size());
+      output.at(i) = abs(dot_product) / (per_lag_norm({a.data()+i, b.size()}) * b_norm);
+    }
+  };
+
+  int iterations = 20;
+  vector<float> result;
+  vector<float> expected;
+  auto t0 = chrono::steady_clock::now();
+  for (int i = 0; i < iterations; i++) {
+    correlate_per_lag(expected, signal, ref);
+  }
+  auto t1 = chrono::steady_clock::now();
+  for (int i = 0; i < iterations; i++) {
+    correlate_magnitude_normalized(result, signal, ref);
+  }
+  auto t2 = chrono::steady_clock::now();
+
+  cout << "per-lag norms: " << chrono::duration<double, micro>(t1 - t0).count() / iterations << " us per correlation" << endl;
+  cout << "running-energy norms: " << chrono::duration<double, micro>(t2 - t1).count() / iterations << " us per correlation" << endl;
+  ASSERT_EQ(result.size(), expected.size());
+  for (size_t i = 0; i < result.size(); i += 1000) {
+    EXPECT_NEAR(result.at(i), expected.at(i), 1e-4);
+  }
+}
+
+TEST_F(dsp_test, moving_correlation_delayed) {
+  vector<complex<float>> signal(300);
+  uint32_t state = 7;
+  auto next = [&state]() {
+    state = state * 1103515245 + 12345;
+    return ((state >> 8) & 0xffff) / 32768.0f - 1.0f;
+  };
+  for (auto& value : signal) {
+    value = {next(), next()};
+  }
+
+  /* Matches a direct dot product over each window against the zero-padded delayed copy */
+  size_t delay = 64;
+  size_t window_size = 18;
+  vector<complex<float>> delayed(delay, 0);
+  delayed.insert(delayed.end(), signal.begin(), signal.end() - delay);
+
+  vector<complex<float>> result;
+  vector<complex<float>> moving;
+  moving_correlate_delayed(result, signal, delay, window_size);
+  moving_correlate(moving, signal, delayed, window_size);
+  ASSERT_EQ(result.size(), signal.size());
+  ASSERT_EQ(moving.size(), signal.size());
+  for (size_t i = 0; i < signal.size(); i++) {
+    complex<float> expected = 0;
+    for (size_t k = (i + 1 > window_size ? i + 1 - window_size : 0); k <= i; k++) {
+      expected += signal[k] * conj(delayed[k]);
+    }
+    EXPECT_NEAR(abs(result[i] - expected), 0, 1e-4);
+    EXPECT_NEAR(abs(moving[i] - expected), 0, 1e-4);
+  }
+}
@@ -0,0 +1,81 @@
+#include <atomic>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+#include "gtest/gtest.h"
+#include "executor.h"
+
+class executor_test : public ::testing::Test {
+ protected:
+  executor_test() {
+  }
+};
+
+TEST_F(executor_test, nested_task_groups) {
+  nr::executor exec(4);
+  std::vector<int> results(16, 0);
+
+  /* Outer tasks wait on inner groups, which must not deadlock the pool */
+  nr::task_group outer(&exec);
+  for (int i = 0; i < 16; i++) {
+    outer.run([&exec, &results, i]() {
+      std::atomic<int> sum = 0;
+      nr::task_group inner(&exec);
+      for (int j = 0; j < 8; j++) {
+        inner.run([&sum, j]() { sum += j; });
+      }
+      inner.wait();
+      results.at(i) = i + sum;
+    });
+  }
+  outer.wait();
+
+  for (int i = 0; i < 16; i++) {
+    EXPECT_EQ(results.at(i), i + 28);
+  }
+}
+
+TEST_F(executor_test, inline_and_exceptions) {
+  /* Without an executor tasks run inline */
+  int counter = 0;
+  nr::task_group inline_group(nullptr);
+  inline_group.run([&counter]() { counter++; });
+  EXPECT_EQ(counter, 1);
+  inline_group.wait();
+
+  nr::executor exec(2);
+  nr::task_group group(&exec);
+  group.run([]() { throw std::runtime_error("task failed"); });
+  EXPECT_THROW(group.wait(), std::runtime_error);
+}
+
+TEST_F(executor_test, wait_only_runs_own_tasks) {
+  nr::executor exec(1);
+
+  /* The only pool thread is busy, so the waiting thread runs the group's task itself */
+  std::atomic<bool> release = false;
+  std::atomic<bool> started = false;
+  exec.submit([&]() {
+    started = true;
+    while (!release) {
+      std::this_thread::yield();
+    }
+  });
+  while (!started) {
+    std::this_thread::yield();
+  }
+  std::atomic<bool> other_ran = false;
+  exec.submit([&other_ran]() { other_ran = true; });
+
+  bool own_ran = false;
+  nr::task_group group(&exec);
+  group.run([&own_ran]() { own_ran = true; });
+  group.wait();
+  EXPECT_TRUE(own_ran);
+  EXPECT_FALSE(other_ran);
+
+  release = true;
+  while (!other_ran) {
+    std::this_thread::yield();
+  }
+}
@@ -0,0 +1,56 @@
+#include <cmath>
+#include <complex>
+#include <thread>
+#include <vector>
+#include "gtest/gtest.h"
+#include "fft_plan.h"
+
+using namespace std;
+
+class fft_plan_test : public ::testing::Test {
+ protected:
+  fft_plan_test() {
+  }
+};
+
+TEST_F(fft_plan_test, forward_inverse_roundtrip) {
+  size_t n = 64;
+  nr::fft_plan& forward = nr::fft_plan::get(n, true);
+  nr::fft_plan& inverse = nr::fft_plan::get(n, false);
+
+  vector<complex<float>> x(n);
+  for (size_t i = 0; i < n; i++) {
+    x[i] = complex<float>(cos(0.3f * i), sin(0.7f * i) + 0.1f * i);
+  }
+
+  // A tone in bin 5
+  for (size_t i = 0; i < n; i++) {
+    forward.input()[i] = polar(1.0f, 2 * (float)M_PI * 5 * i / n);
+  }
+  forward.execute();
+  EXPECT_NEAR(abs(forward.output()[5]), n, 1e-3);
+  EXPECT_NEAR(abs(forward.output()[6]), 0, 1e-3);
+
+  // Neither direction is scaled
+  copy(x.begin(), x.end(), forward.input().begin());
+  forward.execute();
+  copy(forward.output().begin(), forward.output().end(), inverse.input().begin());
+  inverse.execute();
+  for (size_t i = 0; i < n; i++) {
+    EXPECT_NEAR(inverse.output()[i].real(), n * x[i].real(), 1e-3);
+    EXPECT_NEAR(inverse.output()[i].imag(), n * x[i].imag(), 1e-3);
+  }
+}
+
+TEST_F(fft_plan_test, plans_cached_per_thread) {
+  nr::fft_plan* plan = &nr::fft_plan::get(128, true);
+  EXPECT_EQ(plan, &nr::fft_plan::get(128, true));
+  EXPECT_NE(plan, &nr::fft_plan::get(128, false));
+  EXPECT_NE(plan, &nr::fft_plan::get(256, true));
+  EXPECT_EQ(plan->size(), 128);
+
+  nr::fft_plan* other_thread_plan = nullptr;
+  thread t([&other_thread_plan]() { other_thread_plan = &nr::fft_plan::get(128, true); });
+  t.join();
+  EXPECT_NE(plan, other_thread_plan);
+}
@@ -0,0 +1,43 @@
+#include <algorithm>
+#include <cstdint>
+#include "gtest/gtest.h"
+#include "gscn.h"
+
+class gscn_test : public ::testing::Test {
+ protected:
+  gscn_test() {
+  }
+};
+
+TEST_F(gscn_test, gscn_to_frequency) {
+  /* Below 3 GHz: N * 1200 kHz + M * 50 kHz, M = 1, 3, 5 */
+  EXPECT_DOUBLE_EQ(nr::gscn_to_frequency(2), 1'250'000.0);
+  EXPECT_DOUBLE_EQ(nr::gscn_to_frequency(3), 1'350'000.0);
+  EXPECT_DOUBLE_EQ(nr::gscn_to_frequency(4), 1'450'000.0);
+  EXPECT_DOUBLE_EQ(nr::gscn_to_frequency(1569), 627'750'000.0);
+  EXPECT_DOUBLE_EQ(nr::gscn_to_frequency(5279), 2'112'050'000.0);
+
+  /* 3 GHz to 24.25 GHz: 3000 MHz + N * 1.44 MHz */
+  EXPECT_DOUBLE_EQ(nr::gscn_to_frequency(7499), 3'000'000'000.0);
+  EXPECT_DOUBLE_EQ(nr::gscn_to_frequency(7711), 3'305'280'000.0);
+
+  /* Above 24.25 GHz: 24250.08 MHz + N * 17.28 MHz */
+  EXPECT_DOUBLE_EQ(nr::gscn_to_frequency(22256), 24'250'080'000.0);
+}
+
+TEST_F(gscn_test, raster_within_capture) {
+  /* 23.04 MHz around 627.75 MHz, of which 80 % is usable, minus the SSB bandwidth */
+  auto raster = nr::gscn_raster(627'750'000.0, 23'040'000, 3'600'000.0);
+  ASSERT_EQ(raster.size(), 39);
+  EXPECT_EQ(raster.front(), 3 * 517 - 1);
+  EXPECT_EQ(raster.back(), 3 * 529 + 1);
+  EXPECT_TRUE(std::is_sorted(raster.begin(), raster.end()));
+  EXPECT_NE(std::find(raster.begin(), raster.end(), 1569), raster.end());
+
+  /* Above 3 GHz the raster is 1.44 MHz */
+  raster = nr::gscn_raster(3'500'000'000.0, 30'720'000, 7'200'000.0);
+  for (uint32_t gscn : raster) {
+    EXPECT_LE(std::abs(nr::gscn_to_frequency(gscn) - 3'500'000'000.0), (0.8 * 30'720'000 - 7'200'000.0) / 2);
+  }
+  EXPECT_EQ(raster.size(), 12);
+}
@@ -0,0 +1,143 @@
+#include <complex>
+#include <cstdint>
+#include <memory>
+#include <random>
+#include <vector>
+#include "gtest/gtest.h"
+#include "bandwidth_part.h"
+#include "ofdm.h"
+#include "slot_grid.h"
+
+using namespace std;
+
+/**
+ * Keeps the grids it is given.
+ */
+class grid_sink : public worker {
+  public:
+    void process(const shared_ptr<slot_grid>& grid, int64_t metadata) override {
+      grids.push_back(grid);
+    }
+    vector<shared_ptr<slot_grid>> grids;
+};
+
+class ofdm_test : public ::testing::Test {
+ protected:
+  ofdm_test() {
+  }
+};
+
+TEST_F(ofdm_test, demodulates_modulated_slot) {
+  auto bwp = make_shared<bandwidth_part>(1920000, 0, 10);
+  ofdm modulator(bwp);
+  size_t half = bwp->num_subcarriers / 2;
+
+  // Two slots of random REs around DC, padded to the FFT size
+  mt19937 gen(3);
+  normal_distribution<float> dist;
+  vector<symbol> symbols(2 * bwp->symbols_per_slot);
+  for (size_t i = 0; i < symbols.size(); i++) {
+    symbols[i].symbol_index = i % bwp->symbols_per_slot;
+    symbols[i].samples.resize(bwp->fft_size, 0);
+    for (size_t k = 0; k < bwp->num_subcarriers; k++) {
+      symbols[i].samples[bwp->fft_size / 2 - half + k] = complex<float>(dist(gen), dist(gen));
+    }
+  }
+  auto samples = modulator.modulate(symbols);
+
+  // Split mid-symbol, so the second buffer starts with the leftover of the first
+  ofdm demodulator(bwp);
+  auto sink = make_shared<grid_sink>();
+  demodulator.connect(sink);
+  size_t split = bwp->samples_per_slot(0) + bwp->samples_per_symbol(1) / 2;
+  auto first = make_shared<vector<complex<float>>>(samples.begin(), samples.begin() + split);
+  auto second = make_shared<vector<complex<float>>>(samples.begin() + split, samples.end());
+  demodulator.process(first, 0);
+  demodulator.process(second, 0);
+
+  ASSERT_EQ(sink->grids.size(), 2);
+  EXPECT_EQ(sink->grids[0]->size(), bwp->symbols_per_slot);
+  EXPECT_EQ(sink->grids[1]->size(), bwp->symbols_per_slot);
+  size_t i = 0;
+  for (auto& grid : sink->grids) {
+    for (size_t j = 0; j < grid->size(); j++, i++) {
+      EXPECT_EQ(grid->symbols[j].symbol_index, i % bwp->symbols_per_slot);
+      EXPECT_EQ(grid->symbols[j].slot_index, i / bwp->symbols_per_slot);
+      auto row = grid->row(j);
+      for (size_t k = 0; k < bwp->num_subcarriers; k++) {
+        complex<float> expected = symbols[i].samples[bwp->fft_size / 2 - half + k] * (float)bwp->fft_size;
+        EXPECT_NEAR(abs(row[k] - expected), 0, 1e-2);
+      }
+    }
+  }
+
+  // The kept grids are not overwritten by the next buffer
+  EXPECT_NE(sink->grids[0], sink->grids[1]);
+}
+
+TEST_F(ofdm_test, demodulates_only_given_symbols) {
+  auto bwp = make_shared<bandwidth_part>(1920000, 0, 10);
+  ofdm modulator(bwp);
+  size_t half = bwp->num_subcarriers / 2;
+
+  mt19937 gen(5);
+  normal_distribution<float> dist;
+  vector<symbol> symbols(2 * bwp->symbols_per_slot);
+  for (size_t i = 0; i < symbols.size(); i++) {
+    symbols[i].symbol_index = i % bwp->symbols_per_slot;
+    symbols[i].samples.resize(bwp->fft_size, 0);
+    for (size_t k = 0; k < bwp->num_subcarriers; k++) {
+      symbols[i].samples[bwp->fft_size / 2 - half + k] = complex<float>(dist(gen), dist(gen));
+    }
+  }
+  auto samples = make_shared<vector<complex<float>>>(modulator.modulate(symbols));
+
+  // A CORESET of two symbols from symbol 1
+  ofdm demodulator(bwp);
+  vector<uint8_t> symbol_indices = {1, 2};
+  demodulator.set_symbol_indices(symbol_indices);
+  auto sink = make_shared<grid_sink>();
+  demodulator.connect(sink);
+  demodulator.process(samples, 0);
+
+  ASSERT_EQ(sink->grids.size(), 1);
+  auto& grid = sink->grids[0];
+  ASSERT_EQ(grid->size(), 4);
+  for (size_t j = 0; j < grid->size(); j++) {
+    size_t slot = j / 2;
+    size_t l = 1 + j % 2;
+    size_t i = slot * bwp->symbols_per_slot + l;
+    EXPECT_EQ(grid->symbols[j].symbol_index, l);
+    EXPECT_EQ(grid->symbols[j].slot_index, slot);
+    uint64_t sample_index = 0;
+    for (size_t m = 0; m < i; m++) {
+      sample_index += bwp->samples_per_symbol(m % bwp->symbols_per_slot);
+    }
+    EXPECT_EQ(grid->symbols[j].sample_index, sample_index);
+    auto row = grid->row(j);
+    for (size_t k = 0; k < bwp->num_subcarriers; k++) {
+      complex<float> expected = symbols[i].samples[bwp->fft_size / 2 - half + k] * (float)bwp->fft_size;
+      EXPECT_NEAR(abs(row[k] - expected), 0, 1e-2);
+    }
+  }
+}
+
+TEST_F(ofdm_test, grid_to_symbol) {
+  slot_grid grid;
+  grid.reset(2);
+  auto row = grid.add_symbol({100, 3, 1});
+  row[0] = 1;
+  row[1] = 2;
+  row = grid.add_symbol({200, 4, 1});
+  row[0] = 3;
+  row[1] = 4;
+
+  symbol s = grid.to_symbol(0, 2);
+  EXPECT_EQ(s.sample_index, 100);
+  EXPECT_EQ(s.symbol_index, 3);
+  EXPECT_EQ(s.slot_index, 1);
+  EXPECT_EQ(s.samples, vector<complex<float>>({1, 2, 3, 4}));
+
+  grid.reset(2);
+  EXPECT_TRUE(grid.empty());
+}
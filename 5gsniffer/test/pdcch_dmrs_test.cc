@@ -1,7 +1,9 @@
 #include "gtest/gtest.h"
 #include "pdcch.h"
 #include "dmrs.h"
+#include "scrambling_id_solver.h"
 #include "fftw3.h"
+#include <chrono>
 
 class pdcch_dmrs_test : public ::testing::Test {
  protected:
@@ -193,3 +195,282 @@ for (int i_idx = 0 ; i_idx < pdcch_dmrs_indices_al4_regBundle6_Duration1_nonInte
 
 }
 
+
+
+TEST_F(pdcch_dmrs_test, test_scrambling_id_solver) {
+
+dmrs dmrs_pdcch;
+
+uint8_t num_symbols_per_slot = 14;
+std::vector<uint16_t> scrambling_ids = {0, 1, 500, 1007, 40000, 65535};
+
+for (uint16_t scrambling_id : scrambling_ids) {
+  for (uint8_t slot = 0; slot < 20; slot += 7) {
+    uint8_t ofdm_symbol = slot % 3;
+
+    /*c_init is inverted exactly for the scrambling ID*/
+    uint32_t c_init = (((num_symbols_per_slot*slot + ofdm_symbol + 1)<<17)*(2*scrambling_id + 1) + 2*scrambling_id);
+    uint16_t n_id = 0;
+    EXPECT_TRUE(nr::scrambling_id_solver::c_init_to_n_id(c_init & 0x7fffffff, slot, ofdm_symbol, num_symbols_per_slot, n_id));
+    EXPECT_EQ(n_id, scrambling_id);
+
+    /*DMRS of 4 CCEs starting at RB 12, received with an unknown phase*/
+    std::vector<std::complex<float>> pdcch_dmrs_symbols = dmrs_pdcch.generate_pdcch_dmrs_symb(scrambling_id, slot, ofdm_symbol, num_symbols_per_slot, 2*AL_16*18);
+    std::vector<std::complex<float>> rx_dmrs;
+    std::vector<uint16_t> seq_indices;
+    for (uint16_t m = 3*12; m < 3*(12+24); m++) {
+      rx_dmrs.push_back(pdcch_dmrs_symbols.at(m) * std::polar(0.5f, 2.0f + 0.01f*m));
+      seq_indices.push_back(m);
+    }
+
+    n_id = 0;
+    EXPECT_TRUE(nr::scrambling_id_solver::solve(rx_dmrs, seq_indices, slot, ofdm_symbol, num_symbols_per_slot, n_id));
+    EXPECT_EQ(n_id, scrambling_id);
+  }
+}
+
+/*Noise alone should not produce a solution*/
+std::vector<std::complex<float>> noise;
+std::vector<uint16_t> seq_indices;
+uint32_t state = 12345;
+for (uint16_t m = 0; m < 36; m++) {
+  state = state * 1103515245 + 12345;
+  noise.push_back(std::polar(1.0f, (state >> 8) * 1e-6f));
+  seq_indices.push_back(m);
+}
+uint16_t n_id = 0;
+EXPECT_FALSE(nr::scrambling_id_solver::solve(noise, seq_indices, 0, 0, num_symbols_per_slot, n_id));
+
+}
+
+
+TEST_F(pdcch_dmrs_test, test_dmrs_cache_eviction) {
+
+int generated = 0;
+auto generate = [&generated](uint16_t scrambling_id, uint8_t slot_index) {
+  generated++;
+  auto references = std::make_shared<nr::pdcch_dmrs_references>();
+  references->symbols.assign(1024, std::complex<float>(scrambling_id, slot_index));
+  references->offsets = {0, 1024};
+  references->max_candidates = 1;
+  return references;
+};
+
+size_t entry_size = generate(0, 0)->memory_usage();
+generated = 0;
+nr::pdcch_dmrs_cache cache(generate, 2 * entry_size);
+
+auto first = cache.get(1, 0);
+cache.get(2, 0);
+EXPECT_EQ(cache.get(1, 0), first);
+EXPECT_EQ(generated, 2);
+
+/* The least recently used entry (2, 0) is evicted, and references in use stay valid */
+cache.get(3, 0);
+EXPECT_EQ(cache.size(), 2);
+EXPECT_LE(cache.memory_usage(), 2 * entry_size);
+EXPECT_EQ(cache.get(1, 0), first);
+EXPECT_EQ(generated, 3);
+cache.get(2, 0);
+EXPECT_EQ(generated, 4);
+EXPECT_EQ(first->get(0, 0)[0], std::complex<float>(1, 0));
+
+/* Uncached references are generated without evicting anything, unless already cached */
+auto uncached = cache.get_uncached(4, 0);
+EXPECT_EQ(generated, 5);
+EXPECT_EQ(uncached->get(0, 0)[0], std::complex<float>(4, 0));
+EXPECT_EQ(cache.get_uncached(2, 0), cache.get(2, 0));
+EXPECT_EQ(generated, 5);
+EXPECT_EQ(cache.size(), 2);
+
+}
+
+TEST_F(pdcch_dmrs_test, test_hierarchical_search) {
+
+nr::pdcch pdcch;
+coreset coreset_info_(1,48,2,"non-interleaved",6,2,0,1, 0, 14, 10, {8, 4, 2, 1, 0});
+pdcch.set_coreset_info(coreset_info_);
+pdcch.scrambling_id_start = 1;
+pdcch.scrambling_id_end = 1;
+pdcch.dmrs_prefetch = false;
+pdcch.initialize_dmrs_seq();
+
+/* AL4 candidate 0 on top of weak noise, with the default thresholds, which its AL8 parent clears as well */
+uint8_t slot_index = 3;
+symbol symbol_;
+symbol_.slot_index = slot_index;
+symbol_.symbol_index = 0;
+symbol_.samples.resize(48 * 12 * 2);
+uint32_t state = 1;
+for (auto& sample : symbol_.samples) {
+  state = state * 1103515245 + 12345;
+  sample = std::polar(0.05f, (state >> 8) * 1e-6f);
+}
+std::span<uint64_t> sc_indices = pdcch.dmrs_table.dmrs_sc_indices(slot_index, 2, 0);
+std::span<std::complex<float>> reference = pdcch.dmrs_cache->get(1, slot_index)->get(2, 0);
+for (size_t i = 0; i < sc_indices.size(); i++) {
+  symbol_.samples.at(sc_indices[i]) = reference[i] * std::complex<float>(0.6, 0.8);
+}
+
+std::vector<dci> flat_dcis;
+pdcch.correlate_DMRS(symbol_, flat_dcis);
+pdcch.hierarchical_search = true;
+pdcch.hierarchical_energy_ratio = 0; // Only the pruning is compared
+std::vector<dci> hierarchical_dcis;
+pdcch.correlate_DMRS(symbol_, hierarchical_dcis);
+
+/* The candidates contained in the AL8 parent are deferred rather than dropped */
+auto found = [](std::vector<dci>& dcis, uint8_t AL, uint8_t candidate_idx) {
+  for (dci& dci_ : dcis) {
+    if (dci_.get_found_aggregation_level() == AL && dci_.get_found_candidate() == candidate_idx) {
+      return true;
+    }
+  }
+  return false;
+};
+EXPECT_TRUE(found(flat_dcis, 4, 0));
+EXPECT_TRUE(found(flat_dcis, 8, 0));
+EXPECT_TRUE(found(hierarchical_dcis, 8, 0));
+ASSERT_TRUE(found(hierarchical_dcis, 4, 0));
+size_t num_deferred = 0;
+for (dci& dci_ : hierarchical_dcis) {
+  num_deferred += dci_.get_correlation() == nr::pdcch::deferred_correlation;
+}
+EXPECT_GT(num_deferred, 0);
+
+/* If the parent does not decode, correlating the deferred candidates finds the same DCIs */
+pdcch.correlate_deferred(symbol_, hierarchical_dcis);
+EXPECT_EQ(hierarchical_dcis.size(), flat_dcis.size());
+for (dci& dci_ : flat_dcis) {
+  EXPECT_TRUE(found(hierarchical_dcis, dci_.get_found_aggregation_level(), dci_.get_found_candidate()));
+}
+
+}
+
+TEST_F(pdcch_dmrs_test, test_delete_lower_AL_dcis) {
+
+nr::pdcch pdcch;
+coreset coreset_info_(1,48,2,"non-interleaved",6,2,0,1, 0, 14, 10, {8, 4, 2, 1, 0});
+pdcch.set_coreset_info(coreset_info_);
+
+/* 16 CCEs: the AL8 candidate covers CCEs 0-7, AL4 candidate 1 CCEs 8-11 and AL1 candidate k CCE 2k */
+auto candidate = [](uint8_t AL, uint8_t candidate_idx, uint8_t max_num_candidate) {
+  return dci(true, AL, candidate_idx, max_num_candidate, 0, 0, "ue-rnti", "dci-unknown", 0, {}, 0, 1, 3, 0, 0.5);
+};
+std::vector<dci> dcis = {candidate(4, 0, 2), candidate(8, 0, 1), candidate(4, 1, 2), candidate(1, 0, 8), candidate(1, 5, 8)};
+
+/* Only the candidates within the decoded AL8 candidate are deleted, the first one included */
+EXPECT_EQ(pdcch.delete_lower_AL_dcis(1, 3, 0, 0, 8, dcis), 2);
+ASSERT_EQ(dcis.size(), 3);
+EXPECT_EQ(dcis[0].get_found_aggregation_level(), 8);
+EXPECT_EQ(dcis[1].get_found_aggregation_level(), 4);
+EXPECT_EQ(dcis[1].get_found_candidate(), 1);
+EXPECT_EQ(dcis[2].get_found_aggregation_level(), 1);
+EXPECT_EQ(dcis[2].get_found_candidate(), 5);
+
+}
+
+TEST_F(pdcch_dmrs_test, test_recovered_rnti_confirmation) {
+
+nr::pdcch pdcch;
+pdcch.sample_rate_time = 1000; // One sample per ms
+pdcch.rnti_start = 1;
+pdcch.rnti_end = 0xfff0;
+pdcch.rnti_recovery_min_hits = 2;
+pdcch.rnti_recovery_window_ms = 1000;
+pdcch.rnti_aging_ms = 5000;
+
+/* Two recoveries within the window confirm an RNTI, a single one does not */
+EXPECT_FALSE(pdcch.is_plausible_rnti(100, 0));
+EXPECT_TRUE(pdcch.is_plausible_rnti(100, 500));
+EXPECT_TRUE(pdcch.is_plausible_rnti(100, 3000));
+
+/* The confirmation expires, and a lone false recovery does not bring it back */
+EXPECT_FALSE(pdcch.is_plausible_rnti(100, 10000));
+
+/* An RNTI decoded with a full CRC is confirmed */
+pdcch.confirm_rnti(200, 10000);
+EXPECT_TRUE(pdcch.is_plausible_rnti(200, 11000));
+EXPECT_FALSE(pdcch.is_plausible_rnti(200, 20000));
+
+}
+
+TEST_F(pdcch_dmrs_test, test_candidate_equalization) {
+
+nr::pdcch pdcch;
+coreset coreset_info_(1,48,2,"non-interleaved",6,2,0,1, 0, 14, 10, {8, 4, 2, 1, 0});
+pdcch.set_coreset_info(coreset_info_);
+pdcch.dmrs_prefetch = false;
+pdcch.initialize_dmrs_seq();
+
+uint8_t slot_index = 5;
+symbol symbol_;
+symbol_.slot_index = slot_index;
+symbol_.symbol_index = 0;
+symbol_.samples.resize(48 * 12 * 2);
+uint32_t state = 7;
+for (auto& sample : symbol_.samples) {
+  state = state * 1103515245 + 12345;
+  sample = std::polar(0.5f + (state >> 24) / 512.0f, (state >> 8) * 1e-6f);
+}
+
+/* Every candidate equalizes as the whole-symbol channel estimate gathered at its data REs */
+for (uint8_t agg_level = 0; agg_level < 4; agg_level++) {
+  for (uint8_t candidate_idx = 0; candidate_idx < coreset_info_.get_candidates_search_space().at(agg_level); candidate_idx++) {
+    std::span<uint64_t> sc_indices = pdcch.dmrs_table.dmrs_sc_indices(slot_index, agg_level, candidate_idx);
+    std::span<uint16_t> data_indices = pdcch.dmrs_table.data_sc_indices(slot_index, agg_level, candidate_idx);
+    std::span<std::complex<float>> reference = pdcch.dmrs_cache->get(1, slot_index)->get(agg_level, candidate_idx);
+
+    symbol full = symbol_;
+    full.channel_estimate(std::vector<std::complex<float>>(reference.begin(), reference.end()), std::vector<uint64_t>(sc_indices.begin(), sc_indices.end()), data_indices.front(), data_indices.back());
+
+    dci candidate;
+    candidate.set_pdcch_scrambling_id(1);
+    candidate.set_n_slot(slot_index);
+    candidate.set_found_aggregation_level(1 << agg_level);
+    candidate.set_found_candidate(candidate_idx);
+    std::vector<std::complex<float>> equalized;
+    pdcch.estimate_channel_dci(symbol_, candidate, equalized);
+
+    ASSERT_EQ(equalized.size(), data_indices.size());
+    for (size_t i = 0; i < data_indices.size(); i++) {
+      EXPECT_NEAR(std::abs(equalized[i] - full.samples_eq.at(data_indices[i])), 0, 1e-3 * std::abs(full.samples_eq.at(data_indices[i])) + 1e-5);
+    }
+  }
+}
+
+}
+
+/*Microbenchmark of the per-symbol DMRS correlation, run with --gtest_also_run_disabled_tests*/
+TEST_F(pdcch_dmrs_test, DISABLED_benchmark_correlate_DMRS) {
+
+nr::pdcch pdcch;
+coreset coreset_info_(1,48,2,"non-interleaved",6,2,0,1, 0, 14, 10, {8, 4, 2, 1, 0});
+pdcch.set_coreset_info(coreset_info_);
+pdcch.scrambling_id_start = 1;
+pdcch.scrambling_id_end = 1;
+pdcch.AL_corr_thresholds = {1.1, 1.1, 1.1, 1.1, 1.1}; // Measure correlation only
+pdcch.initialize_dmrs_seq();
+
+symbol symbol_;
+symbol_.slot_index = 3;
+symbol_.symbol_index = 0;
+symbol_.samples.resize(48 * 12 * 2);
+uint32_t state = 1;
+for (auto& sample : symbol_.samples) {
+  state = state * 1103515245 + 12345;
+  sample = std::polar(1.0f, (state >> 8) * 1e-6f);
+}
+
+int iterations = 1000;
+std::vector<dci> found_dci_list;
+auto t0 = std::chrono::steady_clock::now();
+for (int i = 0; i < iterations; i++) {
+  pdcch.correlate_DMRS(symbol_, found_dci_list);
+}
+auto t1 = std::chrono::steady_clock::now();
+
+std::cout << "correlate_DMRS: " << std::chrono::duration<double, std::micro>(t1 - t0).count() / iterations << " us per symbol" << std::endl;
+EXPECT_TRUE(found_dci_list.empty());
+
+}
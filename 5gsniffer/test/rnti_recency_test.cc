@@ -0,0 +1,44 @@
+#include <cstdint>
+#include <vector>
+#include "gtest/gtest.h"
+#include "rnti_recency.h"
+
+class rnti_recency_test : public ::testing::Test {
+ protected:
+  rnti_recency_test() {
+  }
+};
+
+TEST_F(rnti_recency_test, move_to_front) {
+  nr::rnti_recency rntis;
+  rntis.reset({10, 11, 12, 13, 14});
+
+  EXPECT_FALSE(rntis.promote(99, 0));
+  EXPECT_TRUE(rntis.promote(13, 0));
+  EXPECT_TRUE(rntis.promote(11, 0));
+
+  /* Snapshots handed out before publishing are not modified */
+  nr::rnti_recency::snapshot_ptr before = rntis.snapshot();
+  rntis.publish(0);
+  EXPECT_EQ(*before, std::vector<uint16_t>({10, 11, 12, 13, 14}));
+  EXPECT_EQ(*rntis.snapshot(), std::vector<uint16_t>({11, 13, 10, 12, 14}));
+
+  EXPECT_TRUE(rntis.promote(13, 1));
+  rntis.publish(1);
+  EXPECT_EQ(*rntis.snapshot(), std::vector<uint16_t>({13, 11, 10, 12, 14}));
+}
+
+TEST_F(rnti_recency_test, aging) {
+  nr::rnti_recency rntis;
+  rntis.reset({10, 11, 12, 13, 14});
+  rntis.set_max_age(100);
+
+  rntis.promote(14, 0);
+  rntis.promote(12, 50);
+  rntis.publish(50);
+  EXPECT_EQ(*rntis.snapshot(), std::vector<uint16_t>({12, 14, 10, 11, 13}));
+
+  /* 14 was last found 120 epochs ago and sinks back to its initial position */
+  rntis.publish(120);
+  EXPECT_EQ(*rntis.snapshot(), std::vector<uint16_t>({12, 10, 11, 13, 14}));
+}
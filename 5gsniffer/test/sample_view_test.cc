@@ -0,0 +1,56 @@
+#include <complex>
+#include <memory>
+#include <vector>
+#include "gtest/gtest.h"
+#include "sample_view.h"
+#include "worker.h"
+
+/* Records the buffers it receives */
+class buffer_recorder : public worker {
+  public:
+    void process(shared_ptr<vector<complex<float>>>& samples, int64_t metadata) override {
+      buffers.push_back(samples);
+    }
+    vector<shared_ptr<vector<complex<float>>>> buffers;
+};
+
+class sample_view_test : public ::testing::Test {
+ protected:
+  sample_view_test() {
+  }
+};
+
+TEST_F(sample_view_test, views_share_the_buffer) {
+  auto buffer = make_shared<vector<complex<float>>>(vector<complex<float>>{1, 2, 3, 4, 5});
+  sample_view view(buffer, 1, 3);
+  EXPECT_EQ(view.size(), 3);
+  EXPECT_EQ(view.samples().data(), buffer->data() + 1);
+  EXPECT_FALSE(view.is_whole());
+  EXPECT_TRUE(sample_view(buffer).is_whole());
+  EXPECT_EQ(buffer.use_count(), 2);
+}
+
+TEST_F(sample_view_test, zeros) {
+  sample_view small = sample_view::zeros(3);
+  sample_view large = sample_view::zeros(100);
+  EXPECT_EQ(small.size(), 3);
+  EXPECT_EQ(large.size(), 100);
+  EXPECT_FALSE(large.is_whole());
+  for (complex<float> sample : large.samples()) {
+    EXPECT_EQ(sample, complex<float>(0));
+  }
+  /* Earlier views keep their own buffer */
+  EXPECT_EQ(small.samples()[2], complex<float>(0));
+}
+
+TEST_F(sample_view_test, worker_receives_views_as_buffers) {
+  auto recorder = make_shared<buffer_recorder>();
+  auto buffer = make_shared<vector<complex<float>>>(vector<complex<float>>{1, 2, 3, 4, 5});
+
+  /* A whole view hands on the buffer itself, a partial one a copy of its samples */
+  recorder->worker::process(sample_view(buffer), 0);
+  recorder->worker::process(sample_view(buffer, 3, 2), 0);
+  ASSERT_EQ(recorder->buffers.size(), 2);
+  EXPECT_EQ(recorder->buffers.at(0), buffer);
+  EXPECT_EQ(*recorder->buffers.at(1), vector<complex<float>>({4, 5}));
+}
@@ -0,0 +1,71 @@
+#include <cstdint>
+#include <vector>
+#include "gtest/gtest.h"
+#include "search_space_discovery.h"
+
+class search_space_discovery_test : public ::testing::Test {
+ protected:
+  search_space_discovery_test() {
+  }
+};
+
+TEST_F(search_space_discovery_test, disabled) {
+  nr::search_space_discovery discovery;
+  discovery.configure(0, 1000, 100);
+  discovery.update(0);
+  discovery.record(7, 300);
+  discovery.update(100000);
+  EXPECT_TRUE(discovery.is_full_scan());
+  EXPECT_FALSE(discovery.restricts_scrambling_ids());
+  EXPECT_FALSE(discovery.restricts_rntis());
+}
+
+TEST_F(search_space_discovery_test, phases) {
+  nr::search_space_discovery discovery;
+  discovery.configure(2000, 1000, 100);
+
+  /* The window starts at the first chunk */
+  discovery.update(5000);
+  EXPECT_TRUE(discovery.is_full_scan());
+  discovery.record(500, 17921);
+  discovery.record(12, 17922);
+  discovery.record(500, 300);
+  EXPECT_FALSE(discovery.restricts_scrambling_ids());
+
+  discovery.update(7000);
+  EXPECT_FALSE(discovery.is_full_scan());
+  EXPECT_TRUE(discovery.restricts_scrambling_ids());
+  EXPECT_TRUE(discovery.restricts_rntis());
+  EXPECT_EQ(discovery.get_scrambling_ids(), std::vector<uint16_t>({12, 500}));
+  EXPECT_EQ(discovery.get_num_rnti_blocks(), 2);
+  EXPECT_TRUE(discovery.contains_rnti(17920));
+  EXPECT_TRUE(discovery.contains_rnti(511));
+  EXPECT_FALSE(discovery.contains_rnti(512));
+
+  /* The last 100 ms of every period rescan the whole range */
+  discovery.update(7899);
+  EXPECT_FALSE(discovery.is_full_scan());
+  discovery.update(7900);
+  EXPECT_TRUE(discovery.is_full_scan());
+  uint32_t version = discovery.get_rnti_blocks_version();
+  discovery.record(12, 40000);
+  EXPECT_NE(discovery.get_rnti_blocks_version(), version);
+  discovery.update(8000);
+  EXPECT_FALSE(discovery.is_full_scan());
+  EXPECT_TRUE(discovery.contains_rnti(40000));
+}
+
+TEST_F(search_space_discovery_test, nothing_discovered) {
+  nr::search_space_discovery discovery;
+  discovery.configure(1000, 0, 0);
+  discovery.update(0);
+  discovery.update(1000);
+  EXPECT_FALSE(discovery.is_full_scan());
+  EXPECT_FALSE(discovery.restricts_scrambling_ids());
+  EXPECT_FALSE(discovery.restricts_rntis());
+
+  /* Without rescans, the steady state lasts */
+  discovery.record(3, 3);
+  discovery.update(1000000);
+  EXPECT_TRUE(discovery.restricts_scrambling_ids());
+}
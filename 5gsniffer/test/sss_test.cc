@@ -240,4 +240,37 @@ TEST_F(sss_test, test_sss_generate_all_sequences) {
     EXPECT_FLOAT_EQ((sss_seq_330_2.at(i)).real(), (sss_seq_ref_330_2.at(i)).real()) << "Vectors x and y differ at real index " << i;
     EXPECT_FLOAT_EQ((sss_seq_330_2.at(i)).imag(), (sss_seq_ref_330_2.at(i)).imag()) << "Vectors x and y differ at imaginary index " << i;
   }
-}
\ No newline at end of file
+}
+
+TEST_F(sss_test, test_sss_table) {
+  const sss_table& table = sss_table::get();
+  sss ssss(0,0);
+  for (uint16_t nid_1 : {0, 10, 200, 335}) {
+    for (uint8_t nid_2 = 0; nid_2 <= nid_2_max; nid_2++) {
+      auto sss_seq = ssss.generate_sss_seq(nid_1, nid_2);
+      auto row = table.get_sss_seq(nid_1, nid_2);
+      ASSERT_EQ(row.size(), sss_length);
+      for (int i = 0; i < sss_length; ++i) {
+        EXPECT_FLOAT_EQ(row[i], sss_seq.at(i).real());
+      }
+    }
+  }
+
+  // Received SSS of NID1 200 and NID2 1, with a phase rotation
+  auto sss_seq = ssss.generate_sss_seq(200, 1);
+  std::vector<std::complex<float>> sss_res(sss_seq.begin(), sss_seq.end());
+  for (auto& re : sss_res) {
+    re *= std::polar(0.5f, 1.0f);
+  }
+
+  std::vector<float> correlations;
+  table.correlate(correlations, sss_res, 1);
+  ASSERT_EQ(correlations.size(), nid_1_max + 1);
+  EXPECT_EQ(std::max_element(correlations.begin(), correlations.end()) - correlations.begin(), 200);
+  EXPECT_NEAR(correlations.at(200), 1.0f, 1e-5);
+
+  // Jointly with the NID2
+  table.correlate_all(correlations, sss_res);
+  ASSERT_EQ(correlations.size(), nid_max + 1);
+  EXPECT_EQ(std::max_element(correlations.begin(), correlations.end()) - correlations.begin(), 1 * (nid_1_max + 1) + 200);
+}
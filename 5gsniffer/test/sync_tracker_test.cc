@@ -0,0 +1,111 @@
+#include <algorithm>
+#include <cmath>
+#include <complex>
+#include <cstdint>
+#include <random>
+#include <vector>
+#include "gtest/gtest.h"
+#include "sync_tracker.h"
+#include "decimator.h"
+#include "dsp.h"
+#include "fft_plan.h"
+#include "pss.h"
+
+using namespace std;
+
+class sync_tracker_test : public ::testing::Test {
+ protected:
+  sync_tracker_test() {
+  }
+};
+
+TEST_F(sync_tracker_test, follows_timing_drift) {
+  nr::sync_tracker tracker(0.5f, 0.05f, 0.5f, 0.2f, 3);
+  tracker.reset(100.0f);
+
+  /* The PSS drifts by 0.7 samples per SSB, and slips bring it back */
+  float offset = 0;
+  for (int i = 0; i < 200; i++) {
+    offset += 0.7f;
+    EXPECT_TRUE(tracker.update(offset, 0, 0.8f));
+    offset -= tracker.take_slip();
+  }
+  EXPECT_NEAR(tracker.get_drift(), 0.7f, 0.05f);
+  EXPECT_LT(std::abs(offset), 1.5f);
+  EXPECT_TRUE(tracker.is_locked());
+}
+
+TEST_F(sync_tracker_test, converges_on_cfo) {
+  nr::sync_tracker tracker(0.5f, 0.05f, 0.5f, 0.2f, 3);
+  tracker.reset(100.0f);
+  for (int i = 0; i < 30; i++) {
+    tracker.update(0, 250.0f - tracker.get_cfo(), 0.8f);
+  }
+  EXPECT_NEAR(tracker.get_cfo(), 250.0f, 1e-2);
+  EXPECT_EQ(tracker.take_slip(), 0);
+}
+
+TEST_F(sync_tracker_test, loses_lock_after_misses) {
+  nr::sync_tracker tracker(0.5f, 0.05f, 0.5f, 0.2f, 3);
+  tracker.reset(0);
+
+  /* Weak correlations are rejected and leave the estimates untouched */
+  EXPECT_FALSE(tracker.update(10.0f, 500.0f, 0.1f));
+  tracker.miss();
+  EXPECT_TRUE(tracker.is_locked());
+  EXPECT_EQ(tracker.get_cfo(), 0);
+  EXPECT_EQ(tracker.take_slip(), 0);
+
+  /* A good SSB clears the misses */
+  EXPECT_TRUE(tracker.update(0, 0, 0.5f));
+  tracker.miss();
+  tracker.miss();
+  EXPECT_TRUE(tracker.is_locked());
+  tracker.miss();
+  EXPECT_FALSE(tracker.is_locked());
+}
+
+TEST_F(sync_tracker_test, pss_window_centered) {
+  /* PSS of NID2 0 at 15.36 MHz, searched at 3.84 MHz with a CP of margin */
+  const size_t factor = 4;
+  const size_t margin = 18;
+  const size_t window_length = 2 * margin + 5 * (256 + 18);
+  nr::fft_plan& ifft = nr::fft_plan::get(ssb_nfft * factor, false);
+  auto spectrum = ifft.input();
+  std::fill(spectrum.begin(), spectrum.end(), 0);
+  auto pss_seq_f = pss(0).get_pss_seq_f();
+  for (size_t i = 0; i < pss_seq_f.size(); i++) {
+    spectrum[ssb_nfft * factor / 2 - 64 + i] = pss_seq_f[i];
+  }
+  std::rotate(spectrum.begin(), spectrum.begin() + ssb_nfft * factor / 2, spectrum.end());
+  ifft.execute();
+
+  mt19937 gen(7);
+  normal_distribution<float> dist(0, 1e-3);
+  vector<complex<float>> samples(40000);
+  for (auto& sample : samples) {
+    sample = complex<float>(dist(gen), dist(gen));
+  }
+  const double expected_pss = 20000;
+  std::copy(ifft.output().begin(), ifft.output().end(), samples.begin() + expected_pss);
+
+  decimator downsampler(15'360'000, 3'840'000, 51, 0.08f, 70.0f, 16);
+  nr::pss_window search(expected_pss, margin, window_length, 1.0f / factor, downsampler.get_delay());
+  ASSERT_GE(search.input_start, 0);
+  vector<complex<float>> downsampled;
+  downsampler.execute({samples.data() + search.input_start, static_cast<size_t>(search.input_length)}, downsampled);
+  ASSERT_GE(downsampled.size(), search.transient + window_length);
+
+  auto pss_seq_t = pss(0).get_pss_seq_t();
+  vector<float> correlations;
+  correlate_magnitude_normalized(correlations, {downsampled.data() + search.transient, 2 * margin + pss_seq_t.size()}, pss_seq_t);
+  size_t peak = std::max_element(correlations.begin(), correlations.end()) - correlations.begin();
+  ASSERT_GT(peak, 0);
+  ASSERT_LT(peak + 1, correlations.size());
+  float left = correlations[peak - 1], center = correlations[peak], right = correlations[peak + 1];
+  float fraction = 0.5f * (left - right) / (left - 2 * center + right);
+
+  /* A PSS at its expected position is found there, in the middle of the lags searched */
+  EXPECT_NEAR(peak + fraction, margin, 1.0);
+  EXPECT_NEAR(search.position(peak + fraction), expected_pss, 0.1);
+}